@@ -96,6 +96,13 @@ void CommandFactory::initialize() {
     registerCommand(std::make_shared<SaveCommand>());
     registerCommand(std::make_shared<ListCommand>());
     registerCommand(std::make_shared<AddCommand>());
+    registerCommand(std::make_shared<QueryCommand>());
+    registerCommand(std::make_shared<FindCommand>());
+    registerCommand(std::make_shared<LsCommand>());
+    registerCommand(std::make_shared<TreeCommand>());
+    registerCommand(std::make_shared<VerifyCommand>());
+    registerCommand(std::make_shared<ExtractCommand>());
+    registerCommand(std::make_shared<CatCommand>());
 
     /* register aliases */
     for (const auto& command : commands) {
@@ -0,0 +1,34 @@
+#include "command.hpp"
+#include <iostream>
+#include <unistd.h>
+
+/* cat command implementation, streams the uncompressed bytes of an entry to stdout */
+class CatCommand : public Command {
+public:
+    CatCommand() : Command("cat") {}
+
+    bool execute(ZipHandler& zip_handler, const std::vector<std::string>& params) override {
+        if (params.empty() || params[0] == "") {
+            std::cout << "Error: Entry is required for cat command" << std::endl;
+            std::cout << "Usage: cat <index|name>" << std::endl;
+            return true;
+        }
+
+        zip_handler.cat(joinParams(params, 0), STDOUT_FILENO);
+        std::cout << std::endl;
+        return true;
+    }
+
+    std::string getDescription() const override {
+        return "Print the uncompressed contents of an entry";
+    }
+
+    std::string buildHelp() const override {
+        std::string ret = "cat <index|name>";
+        if (ret.length() < 15) {
+            ret.append(15 - ret.length(), ' ');
+        }
+        ret += "- " + getDescription();
+        return ret;
+    }
+};
@@ -37,6 +37,27 @@ public:
         return ret;
     }
 
+protected:
+    /**
+     * rebuild a parameter that may contain spaces, params were split on every space
+     * surrounding single or double quotes are removed, e.g. '*.png'
+     * @param params command parameters
+     * @param first index of the first parameter that belongs to the value
+     */
+    static std::string joinParams(const std::vector<std::string>& params, size_t first) {
+        std::string value;
+        for (size_t i = first; i < params.size(); ++i) {
+            if (i > first) {
+                value += " ";
+            }
+            value += params[i];
+        }
+        if (value.size() >= 2 && (value.front() == '\'' || value.front() == '"') && value.back() == value.front()) {
+            value = value.substr(1, value.size() - 2);
+        }
+        return value;
+    }
+
 private:
     std::string name;
 };
@@ -8,5 +8,12 @@
 #include "exit.cpp"
 #include "help.cpp"
 #include "print.cpp"
+#include "query.cpp"
+#include "find.cpp"
+#include "ls.cpp"
+#include "tree.cpp"
+#include "verify.cpp"
+#include "extract.cpp"
+#include "cat.cpp"
 
 #endif /* COMMAND_LIST_HPP */
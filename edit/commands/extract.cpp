@@ -0,0 +1,44 @@
+#include "command.hpp"
+#include <iostream>
+
+/* extract command implementation, writes one entry to a file with its CRC-32 checked on the way */
+class ExtractCommand : public Command {
+public:
+    ExtractCommand() : Command("extract") {}
+
+    bool execute(ZipHandler& zip_handler, const std::vector<std::string>& params) override {
+        if (params.size() < 2) {
+            std::cout << "Error: Entry and destination are required for extract command" << std::endl;
+            std::cout << "Usage: extract <index|name> <dest>" << std::endl;
+            std::cout << "       extract all <dir>" << std::endl;
+            return true;
+        }
+
+        if (params.size() == 2 && params[0] == "all") {
+            zip_handler.extractAll(params[1]);
+            return true;
+        }
+
+        /* the destination is the last word, names may contain spaces */
+        std::vector<std::string> name_params(params.begin(), params.end() - 1);
+        zip_handler.extract(joinParams(name_params, 0), params.back());
+        return true;
+    }
+
+    std::vector<std::string> getAliases() const override {
+        return {"x"};
+    }
+
+    std::string getDescription() const override {
+        return "Extract an entry to a file or into a directory, or all entries into a directory";
+    }
+
+    std::string buildHelp() const override {
+        std::string ret = "extract <index|name|all> <dest>";
+        if (ret.length() < 15) {
+            ret.append(15 - ret.length(), ' ');
+        }
+        ret += "- " + getDescription();
+        return ret;
+    }
+};
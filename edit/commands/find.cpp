@@ -0,0 +1,51 @@
+#include "command.hpp"
+#include <iostream>
+
+/* find command implementation, resolves a filename through the hash index */
+class FindCommand : public Command {
+public:
+    FindCommand() : Command("find") {}
+
+    bool execute(ZipHandler& zip_handler, const std::vector<std::string>& params) override {
+        if (params.empty() || params[0] == "") {
+            /* without a name, hunt for names that occur more than once */
+            zip_handler.printDuplicateNames();
+            return true;
+        }
+
+        std::string name = joinParams(params, 0);
+        std::vector<size_t> lfh_rows = zip_handler.findLocalFileHeaders(name);
+        std::vector<size_t> cdh_rows = zip_handler.findCentralDirectoryHeaders(name);
+        for (size_t row : lfh_rows) {
+            std::cout << "LFH[" << row << "]\t" << name << std::endl;
+        }
+        for (size_t row : cdh_rows) {
+            std::cout << "CDH[" << row << "]\t" << name << std::endl;
+        }
+
+        if (lfh_rows.empty() && cdh_rows.empty()) {
+            std::cout << "No entry named " << name << std::endl;
+        } else if (lfh_rows.size() > 1 || cdh_rows.size() > 1) {
+            std::cout << "Warning: Duplicate name (" << lfh_rows.size() << " local file headers, "
+                      << cdh_rows.size() << " central directory headers)" << std::endl;
+        }
+        return true;
+    }
+
+    std::vector<std::string> getAliases() const override {
+        return {"f"};
+    }
+
+    std::string getDescription() const override {
+        return "Find entries by name, without a name list duplicate names";
+    }
+
+    std::string buildHelp() const override {
+        std::string ret = "find [name]";
+        if (ret.length() < 15) {
+            ret.append(15 - ret.length(), ' ');
+        }
+        ret += "- " + getDescription();
+        return ret;
+    }
+};
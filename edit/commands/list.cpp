@@ -5,8 +5,16 @@ class ListCommand : public Command {
 public:
     ListCommand() : Command("list") {}
 
-    bool execute(ZipHandler& zip_handler, const std::vector<std::string>& params) override {
-        if (params.size() == 0 || params[0] == "") {
+    bool execute(ZipHandler& zip_handler, const std::vector<std::string>& raw_params) override {
+        /* input is split at every space, doubled or trailing ones leave empty tokens around a quoted glob */
+        std::vector<std::string> params;
+        for (const std::string& param : raw_params) {
+            if (!param.empty()) {
+                params.push_back(param);
+            }
+        }
+
+        if (params.size() == 0) {
             zip_handler.listLocalFileHeaders();
             zip_handler.listCentralDirectoryHeaders();
         } else if (params.size() == 1){
@@ -15,13 +23,27 @@ public:
             } else if (params[0] == "cdh") {
                 zip_handler.listCentralDirectoryHeaders();
             } else {
-                std::cout << "Error: Invalid parameter for list command" << std::endl;
-                std::cout << "Usage: list [lfh|cdh]" << std::endl;
+                printUsage();
+            }
+        } else {
+            /* list only the entries matching a glob, answered from the name trees; one level of quotes is dropped */
+            std::string pattern = joinParams(params, 1);
+            if (params[0] == "lfh") {
+                zip_handler.listLocalFileHeaders(zip_handler.getLocalFileHeaderTree().glob(pattern));
+            } else if (params[0] == "cdh") {
+                zip_handler.listCentralDirectoryHeaders(zip_handler.getCentralDirectoryHeaderTree().glob(pattern));
+            } else {
+                printUsage();
             }
         }
         return true;
     }
 
+    void printUsage() const {
+        std::cout << "Error: Invalid parameter for list command" << std::endl;
+        std::cout << "Usage: list [lfh|cdh] ['<glob>']" << std::endl;
+    }
+
     std::vector<std::string> getAliases() const override {
         return {"l"};
     }
@@ -0,0 +1,48 @@
+#include "command.hpp"
+#include <iostream>
+
+/* ls command implementation, lists one directory level of the name tree */
+class LsCommand : public Command {
+public:
+    LsCommand() : Command("ls") {}
+
+    bool execute(ZipHandler& zip_handler, const std::vector<std::string>& params) override {
+        const NameTrie& tree = zip_handler.getNameTree();
+        std::string path = params.empty() ? "" : joinParams(params, 0);
+        NameTrie::Cursor cursor;
+        if (!tree.find(path, cursor)) {
+            std::cout << "No such directory: " << path << std::endl;
+            return true;
+        }
+
+        const NameTrie::Node& dir = tree.getNode(cursor.node);
+        std::cout << (path.empty() ? "/" : path) << ": " << dir.entry_count << " entries, "
+                  << dir.compressed_size << " compressed, " << dir.uncompressed_size << " uncompressed bytes"
+                  << std::endl;
+
+        tree.forEachChild(cursor, [&tree](std::string_view comp, const NameTrie::Cursor& next) {
+            const NameTrie::Node& node = tree.getNode(next.node);
+            if (tree.hasChildren(next) || node.directory) {
+                /* a cursor inside a compressed label still carries the aggregates of the whole label node */
+                std::cout << comp << "/\t" << node.entry_count << " entries\t" << node.uncompressed_size
+                          << " bytes" << std::endl;
+            } else {
+                std::cout << comp << "\t" << node.compressed_size << "\t" << node.uncompressed_size << std::endl;
+            }
+        });
+        return true;
+    }
+
+    std::string getDescription() const override {
+        return "List the entries directly below a directory";
+    }
+
+    std::string buildHelp() const override {
+        std::string ret = "ls [dir]";
+        if (ret.length() < 15) {
+            ret.append(15 - ret.length(), ' ');
+        }
+        ret += "- " + getDescription();
+        return ret;
+    }
+};
@@ -18,18 +18,31 @@ public:
                 zip_handler.printEndOfCentralDirectoryRecord();
             } else {
                 std::cout << "Error: Invalid parameter for print command" << std::endl;
-                std::cout << "Usage: print [lfh|cdh|eocdr] [index]" << std::endl;
+                std::cout << "Usage: print [lfh|cdh|eocdr] [index|name]" << std::endl;
             }
         }
         return true;
     }
 
+    /* a purely numeric parameter is an index, anything else is a filename */
+    static bool isIndex(const std::string& param) {
+        return !param.empty() && param.find_first_not_of("0123456789") == std::string::npos;
+    }
+
     void printLocalFileHeaders(ZipHandler& zip_handler, const std::vector<std::string>& params) const {
-        if (params.size() >= 2) {
+        if (params.size() >= 2 && !isIndex(params[1])) {
+            std::vector<size_t> rows = zip_handler.findLocalFileHeaders(joinParams(params, 1));
+            if (rows.empty()) {
+                std::cerr << "Error: No local file header named " << joinParams(params, 1) << std::endl;
+            }
+            for (size_t row : rows) {
+                zip_handler.printLocalFileHeaders(row);
+            }
+        } else if (params.size() >= 2) {
             try {
-                uint16_t index = std::stoi(params[1]);
+                size_t index = std::stoull(params[1]);
                 zip_handler.printLocalFileHeaders(index);
-            } catch (const std::invalid_argument& e) {
+            } catch (const std::logic_error& e) {
                 std::cerr << "Error: Invalid index for local file header" << std::endl;
             }
         } else {
@@ -38,11 +51,19 @@ public:
     }
 
     void printCentralDirectoryHeaders(ZipHandler& zip_handler, const std::vector<std::string>& params) const {
-        if (params.size() >= 2) {
+        if (params.size() >= 2 && !isIndex(params[1])) {
+            std::vector<size_t> rows = zip_handler.findCentralDirectoryHeaders(joinParams(params, 1));
+            if (rows.empty()) {
+                std::cerr << "Error: No central directory header named " << joinParams(params, 1) << std::endl;
+            }
+            for (size_t row : rows) {
+                zip_handler.printCentralDirectoryHeaders(row);
+            }
+        } else if (params.size() >= 2) {
             try {
-                uint16_t index = std::stoi(params[1]);
+                size_t index = std::stoull(params[1]);
                 zip_handler.printCentralDirectoryHeaders(index);
-            } catch (const std::invalid_argument& e) {
+            } catch (const std::logic_error& e) {
                 std::cerr << "Error: Invalid index for central directory header" << std::endl;
             }
         } else {
@@ -59,7 +80,7 @@ public:
     }
 
     std::string buildHelp() const override {
-        std::string ret = "print [lfh|cdh|eocdr] [index]";
+        std::string ret = "print [lfh|cdh|eocdr] [index|name]";
         if (ret.length() < 15) {
             ret.append(15 - ret.length(), ' ');
         }
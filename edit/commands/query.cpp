@@ -0,0 +1,65 @@
+#include "command.hpp"
+#include "defs.hpp"
+#include <iostream>
+
+/* query command implementation, answers whole-archive questions from the columnar central directory index */
+class QueryCommand : public Command {
+public:
+    QueryCommand() : Command("query") {}
+
+    bool execute(ZipHandler& zip_handler, const std::vector<std::string>& params) override {
+        const CentralDirectoryIndex& index = zip_handler.getCentralDirectoryIndex();
+        if (params.empty() || params[0] == "" || params[0] == "total") {
+            printSummary(index);
+        } else if (params[0] == "stored") {
+            printRows(zip_handler, index, index.findByMethod(0));
+        } else if (params[0] == "deflated") {
+            printRows(zip_handler, index, index.findByMethod(8));
+        } else if (params[0] == "encrypted") {
+            printRows(zip_handler, index, index.findByFlag(GPBF_ENCRYPTED));
+        } else if (params[0] == "larger" && params.size() >= 2) {
+            try {
+                uint64_t size = std::stoull(params[1]);
+                printRows(zip_handler, index, index.findLargerThan(size));
+            } catch (const std::logic_error& e) {
+                std::cerr << "Error: Invalid size for query command" << std::endl;
+            }
+        } else {
+            std::cout << "Error: Invalid parameter for query command" << std::endl;
+            std::cout << "Usage: query [total|stored|deflated|encrypted|larger <bytes>]" << std::endl;
+        }
+        return true;
+    }
+
+    void printSummary(const CentralDirectoryIndex& index) const {
+        std::cout << "Entries: " << index.size() << std::endl;
+        std::cout << "Total Compressed Size: " << index.totalCompressedSize() << " bytes" << std::endl;
+        std::cout << "Total Uncompressed Size: " << index.totalUncompressedSize() << " bytes" << std::endl;
+        std::cout << "Stored Entries: " << index.findByMethod(0).size() << std::endl;
+        std::cout << "Encrypted Entries: " << index.findByFlag(GPBF_ENCRYPTED).size() << std::endl;
+    }
+
+    /* same layout as list, plus the uncompressed size */
+    void printRows(const ZipHandler& zip_handler, const CentralDirectoryIndex& index,
+                   const std::vector<size_t>& rows) const {
+        const auto& sizes = index.getUncompressedSizes();
+        for (size_t row : rows) {
+            std::cout << "CDH[" << row << "]\t" << sizes[row] << "\t" << zip_handler.getCentralDirectoryHeaderName(row)
+                      << std::endl;
+        }
+        std::cout << rows.size() << " matching entries" << std::endl;
+    }
+
+    std::string getDescription() const override {
+        return "Query totals and matching entries of the central directory";
+    }
+
+    std::string buildHelp() const override {
+        std::string ret = "query [total|stored|deflated|encrypted|larger <bytes>]";
+        if (ret.length() < 15) {
+            ret.append(15 - ret.length(), ' ');
+        }
+        ret += "- " + getDescription();
+        return ret;
+    }
+};
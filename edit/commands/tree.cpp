@@ -0,0 +1,71 @@
+#include "command.hpp"
+#include <iostream>
+
+/* tree command implementation, prints the name tree below a directory */
+class TreeCommand : public Command {
+public:
+    TreeCommand() : Command("tree") {}
+
+    bool execute(ZipHandler& zip_handler, const std::vector<std::string>& params) override {
+        const NameTrie& tree = zip_handler.getNameTree();
+        std::string path;
+        size_t depth = static_cast<size_t>(-1);
+
+        /* a trailing number is the depth limit, everything before it the directory */
+        std::vector<std::string> args = params;
+        if (!args.empty() && !args.back().empty() &&
+            args.back().find_first_not_of("0123456789") == std::string::npos) {
+            try {
+                depth = std::stoull(args.back());
+            } catch (const std::logic_error& e) {
+                std::cerr << "Error: Invalid depth for tree command" << std::endl;
+                return true;
+            }
+            args.pop_back();
+        }
+        if (!args.empty()) {
+            path = joinParams(args, 0);
+        }
+
+        NameTrie::Cursor cursor;
+        if (!tree.find(path, cursor)) {
+            std::cout << "No such directory: " << path << std::endl;
+            return true;
+        }
+        const NameTrie::Node& dir = tree.getNode(cursor.node);
+        std::cout << (path.empty() ? "/" : path) << " (" << dir.entry_count << " entries, "
+                  << dir.uncompressed_size << " bytes)" << std::endl;
+        printLevel(tree, cursor, 1, depth);
+        return true;
+    }
+
+    void printLevel(const NameTrie& tree, const NameTrie::Cursor& cursor, size_t level, size_t depth) const {
+        if (level > depth) {
+            return;
+        }
+        tree.forEachChild(cursor, [&](std::string_view comp, const NameTrie::Cursor& next) {
+            const NameTrie::Node& node = tree.getNode(next.node);
+            std::cout << std::string(level * 2, ' ') << comp;
+            if (tree.hasChildren(next) || node.directory) {
+                std::cout << "/ (" << node.entry_count << " entries, " << node.uncompressed_size << " bytes)"
+                          << std::endl;
+                printLevel(tree, next, level + 1, depth);
+            } else {
+                std::cout << " (" << node.uncompressed_size << " bytes)" << std::endl;
+            }
+        });
+    }
+
+    std::string getDescription() const override {
+        return "Print the directory tree, optionally limited to a depth";
+    }
+
+    std::string buildHelp() const override {
+        std::string ret = "tree [dir] [depth]";
+        if (ret.length() < 15) {
+            ret.append(15 - ret.length(), ' ');
+        }
+        ret += "- " + getDescription();
+        return ret;
+    }
+};
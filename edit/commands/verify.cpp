@@ -0,0 +1,26 @@
+#include "command.hpp"
+#include <iostream>
+
+/* verify command implementation, checks the CRC-32 and size of every entry */
+class VerifyCommand : public Command {
+public:
+    VerifyCommand() : Command("verify") {}
+
+    bool execute(ZipHandler& zip_handler, const std::vector<std::string>&) override {
+        zip_handler.verify();
+        return true;
+    }
+
+    std::string getDescription() const override {
+        return "Decompress every entry and check its CRC-32 and size";
+    }
+
+    std::string buildHelp() const override {
+        std::string ret = "verify";
+        if (ret.length() < 15) {
+            ret.append(15 - ret.length(), ' ');
+        }
+        ret += "- " + getDescription();
+        return ret;
+    }
+};
@@ -4,6 +4,7 @@
 #include <string>
 #include <fstream>
 #include <csignal>
+#include <unistd.h>
 #include "main_callee.hpp"
 #include "debug_helper.hpp"
 #include "interactive.hpp"
@@ -20,8 +21,16 @@ int main(int argc, char *argv[]) {
         return ret; /* display help information or error message and exit */
     }
 
-    std::cout << "Analyzing ZIP file: " << options.zip_file << " in " << options.mode << " mode" << std::endl;
-    std::cout << "Edit mode is " << (options.is_edit_mode ? "enabled" : "disabled") << std::endl;
+    /* with --cat stdout carries nothing but the entry */
+    if (options.cat_entry.empty()) {
+        std::cout << "Analyzing ZIP file: " << options.zip_file << " in " << options.mode << " mode" << std::endl;
+        std::cout << "Edit mode is " << (options.is_edit_mode ? "enabled" : "disabled") << std::endl;
+    }
+
+    /* forward-only input is decoded on the fly, every header is printed as soon as it is complete */
+    if (options.is_pipe_input) {
+        return printPipeInput(options.zip_file);
+    }
 
     /* read the file content */
     std::ifstream file(options.zip_file, std::ios::binary);
@@ -32,11 +41,41 @@ int main(int argc, char *argv[]) {
 
      /* parse the file content */
     ZipHandler zip_handler(file, options.mode);
+    zip_handler.setJobs(options.jobs);
+    zip_handler.setCompactDirectory(options.compact_directory);
+    if (options.use_index) {
+        zip_handler.setIndexPath(ZipIndex::sidecarPath(options.zip_file));
+    }
+    /* file data is read from the source on demand, so it is needed in every mode */
+    if (!zip_handler.openSource(options.zip_file, options.use_mmap)) {
+        std::cerr << "Error: Failed to open ZIP file" << (options.use_mmap ? " for mapping" : "") << std::endl;
+        return 1;
+    }
     if (!zip_handler.parse()) {
         std::cerr << "Error: Failed to parse ZIP file" << std::endl;
         return 1;
     }
 
+    if (options.verify) {
+        return zip_handler.verify() ? 0 : 1;
+    }
+    if (!options.add_paths.empty()) {
+        if (!zip_handler.addEntries(options.add_paths)) {
+            return 1;
+        }
+        return zip_handler.save(options.output_given ? options.output_path : options.zip_file) ? 0 : 1;
+    }
+    if (!options.cat_entry.empty()) {
+        /* a reader that stops early must show up as EPIPE, not kill the process */
+        signal(SIGPIPE, SIG_IGN);
+        return zip_handler.cat(options.cat_entry, STDOUT_FILENO) ? 0 : 1;
+    }
+    if (!options.extract_entry.empty()) {
+        if (options.extract_entry == "all") {
+            return zip_handler.extractAll(options.output_path) ? 0 : 1;
+        }
+        return zip_handler.extract(options.extract_entry, options.output_path) ? 0 : 1;
+    }
     if (options.is_edit_mode) {
         edit(zip_handler);
     } else {
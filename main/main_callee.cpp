@@ -3,13 +3,26 @@
 #include <iostream>
 #include <string>
 #include "debug_helper.hpp"
+#include "zip_stream_parser.hpp"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 int parseCommandLineOptions(int argc, char* argv[], ParsedOptions& options) {
     cxxopts::Options cli_options("zip_analyzer", "A tool to analyze and edit ZIP files");
     cli_options.add_options()
-        ("f,file", "ZIP file to analyze", cxxopts::value<std::string>())
+        ("f,file", "ZIP file to analyze, - reads a stream from stdin", cxxopts::value<std::string>())
         ("m,mode", "Parsing mode (standard or stream) - only valid with -p option", cxxopts::value<std::string>()->default_value("standard"))
         ("p,print", "Print mode - print the parsed results directly")
+        ("mmap", "Memory-map the ZIP file and parse it in place instead of copying it through a stream")
+        ("index", "Keep a <zip_file>.zidx index next to the archive to skip parsing local file headers on reopen")
+        ("compact", "Keep the central directory as raw records decoded on access, for archives with millions of entries")
+        ("verify", "Check the CRC-32 and size of every entry, then exit with status 1 if any is wrong")
+        ("x,extract", "Extract one entry, given by index or name, or all of them, then exit", cxxopts::value<std::string>())
+        ("cat", "Write the uncompressed contents of one entry, given by index or name, to stdout", cxxopts::value<std::string>())
+        ("a,add", "Add files or directories as new entries and save the archive (to --output if given)", cxxopts::value<std::vector<std::string>>())
+        ("o,output", "Destination of --extract (a file or an existing directory) or of --add (the archive itself by default)", cxxopts::value<std::string>()->default_value("."))
+        ("j,jobs", "Number of worker threads used for parsing (0 = one per CPU)", cxxopts::value<unsigned>()->default_value("1"))
         ("h,help", "Print help");
     cxxopts::ParseResult result;
     try {
@@ -42,8 +55,37 @@ int parseCommandLineOptions(int argc, char* argv[], ParsedOptions& options) {
     /* validate mode option */
     options.zip_file = result["file"].as<std::string>();
 
+    /* verification runs instead of printing or editing */
+    options.verify = result.count("verify") > 0;
+
+    /* extraction also runs instead of printing or editing */
+    if (result.count("extract")) {
+        options.extract_entry = result["extract"].as<std::string>();
+    }
+    options.output_path = result["output"].as<std::string>();
+    options.output_given = result.count("output") > 0;
+    if (result.count("add")) {
+        options.add_paths = result["add"].as<std::vector<std::string>>();
+    }
+    if (result.count("cat")) {
+        options.cat_entry = result["cat"].as<std::string>();
+    }
+
     /* set print mode flag - default is edit mode */
-    options.is_edit_mode = result.count("print") == 0;
+    options.is_edit_mode = result.count("print") == 0 && !options.verify && options.extract_entry.empty() &&
+                           options.cat_entry.empty() && options.add_paths.empty();
+
+    /* memory-mapped backend works with both parsing modes */
+    options.use_mmap = result.count("mmap") > 0;
+
+    /* index sidecar, only consulted in standard mode */
+    options.use_index = result.count("index") > 0;
+
+    /* raw central directory records, only meaningful in standard mode */
+    options.compact_directory = result.count("compact") > 0;
+
+    /* worker threads, 1 keeps the sequential parsers */
+    options.jobs = result["jobs"].as<unsigned>();
 
     /* validate mode option */
     options.mode = "standard"; /* default mode is standard */
@@ -58,5 +100,52 @@ int parseCommandLineOptions(int argc, char* argv[], ParsedOptions& options) {
         return 1;
     }
 
+    /* stdin, FIFOs and sockets cannot seek, they can only be printed in stream mode */
+    struct stat file_stat;
+    options.is_pipe_input = options.zip_file == "-" ||
+                            (stat(options.zip_file.c_str(), &file_stat) == 0 &&
+                             (S_ISFIFO(file_stat.st_mode) || S_ISSOCK(file_stat.st_mode) || S_ISCHR(file_stat.st_mode)));
+    if (options.is_pipe_input) {
+        if (options.verify || !options.extract_entry.empty() || !options.cat_entry.empty() ||
+            !options.add_paths.empty()) {
+            std::cerr << "Error: --verify, --extract, --cat and --add need a seekable file" << std::endl;
+            return 1;
+        }
+        if (options.is_edit_mode) {
+            std::cerr << "Error: Input that cannot seek is only supported with --print" << std::endl;
+            return 1;
+        }
+        if (!result.count("mode")) {
+            options.mode = "stream";
+        }
+        if (options.mode != "stream") {
+            std::cerr << "Error: Input that cannot seek is only supported in stream mode" << std::endl;
+            return 1;
+        }
+    }
+
     return 0; /* options are valid */
 }
+
+int printPipeInput(const std::string& path) {
+    int fd = path == "-" ? STDIN_FILENO : open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Failed to open ZIP stream for reading" << std::endl;
+        return 1;
+    }
+
+    ZipStreamParser parser(fd);
+    uint64_t success_count = parser.parse([](const LocalFileHeader& header) {
+        header.print();
+        return true;
+    });
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+
+    if (success_count == 0) {
+        std::cerr << "Error: Failed to parse ZIP stream" << std::endl;
+        return 1;
+    }
+    return 0;
+}
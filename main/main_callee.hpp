@@ -2,14 +2,37 @@
 #define MAIN_CALLEE_HPP
 
 #include <string>
+#include <vector>
 #include "zip_handler.hpp"
 
 struct ParsedOptions {
     std::string zip_file;
     std::string mode;
     bool is_edit_mode;
+    bool use_mmap;
+    unsigned jobs;
+    bool use_index;
+    bool compact_directory;
+    bool verify;
+    /* entry to extract (index or name), empty when not extracting */
+    std::string extract_entry;
+    std::string output_path;
+    bool output_given;
+    /* files and directories to add as new entries */
+    std::vector<std::string> add_paths;
+    /* entry to write to stdout, empty when not used */
+    std::string cat_entry;
+    /* stdin ("-") or a FIFO, only forward-only stream parsing works on it */
+    bool is_pipe_input;
 };
 
 int parseCommandLineOptions(int argc, char* argv[], ParsedOptions& options);
 
+/**
+ * print the local file headers of a ZIP stream that cannot seek, as they arrive
+ * @param path "-" for stdin, otherwise a FIFO or similar
+ * @return exit code
+ */
+int printPipeInput(const std::string& path);
+
 #endif /* MAIN_CALLEE_HPP */
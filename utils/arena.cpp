@@ -0,0 +1,14 @@
+#include "arena.hpp"
+
+uint8_t* MetadataArena::allocate(size_t size) {
+    if (size == 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<uint8_t*>(resource.allocate(size, 1));
+}
+
+void MetadataArena::release() {
+    std::lock_guard<std::mutex> lock(mutex);
+    resource.release();
+}
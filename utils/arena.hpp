@@ -0,0 +1,36 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+
+/**
+ * monotonic allocator for the variable-length parts of parsed segments (filenames, extra fields, comments)
+ * memory comes from a few geometrically growing blocks and is only given back all at once, so parsing
+ * many small entries costs a handful of allocations and teardown does not walk the headers
+ * allocate may be called from several worker threads
+ */
+class MetadataArena {
+public:
+    MetadataArena() : resource(INITIAL_BLOCK_SIZE) {}
+
+    /* first block, later blocks grow from here */
+    static constexpr size_t INITIAL_BLOCK_SIZE = 64 * 1024;
+
+    /* size bytes without any alignment, valid until release or destruction */
+    uint8_t* allocate(size_t size);
+    /* free every block at once, all pointers handed out become invalid */
+    void release();
+
+    /* forbid copy and move, segments hold pointers into the blocks */
+    MetadataArena(const MetadataArena&) = delete;
+    MetadataArena& operator=(const MetadataArena&) = delete;
+
+private:
+    std::mutex mutex;
+    std::pmr::monotonic_buffer_resource resource;
+};
+
+#endif /* ARENA_HPP */
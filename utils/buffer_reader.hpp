@@ -0,0 +1,104 @@
+#ifndef BUFFER_READER_HPP
+#define BUFFER_READER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+/* decode a little endian integer from unaligned memory */
+template<typename T>
+inline T loadLittleEndian(const uint8_t* data) {
+    static_assert(std::is_unsigned<T>::value, "loadLittleEndian requires an unsigned type");
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        value |= static_cast<T>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+/* encode a little endian integer into unaligned memory */
+template<typename T>
+inline void storeLittleEndian(uint8_t* data, T value) {
+    static_assert(std::is_unsigned<T>::value, "storeLittleEndian requires an unsigned type");
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        data[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+/**
+ * bounds-checked cursor over an in-memory byte range
+ * every read either succeeds completely or leaves the cursor untouched and returns false
+ */
+class BufferReader {
+public:
+    /**
+     * @param data start of the byte range
+     * @param size number of bytes in the range
+     * @param pos initial cursor position inside the range
+     * @param base_offset absolute file offset of data[0], for buffers holding only a slice of the file
+     */
+    BufferReader(const uint8_t* data, size_t size, size_t pos = 0, uint64_t base_offset = 0)
+        : data(data), size(size), pos(pos > size ? size : pos), base_offset(base_offset) {}
+
+    /* read a little endian integer and advance the cursor */
+    template<typename T>
+    bool read(T& value) {
+        if (remaining() < sizeof(T)) {
+            return false;
+        }
+        value = loadLittleEndian<T>(data + pos);
+        pos += sizeof(T);
+        return true;
+    }
+
+    /* return a view of the next length bytes without copying and advance the cursor */
+    bool readBytes(size_t length, const uint8_t*& view) {
+        if (remaining() < length) {
+            return false;
+        }
+        view = data + pos;
+        pos += length;
+        return true;
+    }
+
+    /* peek a little endian integer without advancing the cursor */
+    template<typename T>
+    bool peek(T& value) const {
+        if (remaining() < sizeof(T)) {
+            return false;
+        }
+        value = loadLittleEndian<T>(data + pos);
+        return true;
+    }
+
+    bool skip(size_t length) {
+        if (remaining() < length) {
+            return false;
+        }
+        pos += length;
+        return true;
+    }
+
+    bool seek(size_t new_pos) {
+        if (new_pos > size) {
+            return false;
+        }
+        pos = new_pos;
+        return true;
+    }
+
+    size_t getPosition() const { return pos; }
+    /* file offset of the cursor */
+    uint64_t getAbsolutePosition() const { return base_offset + pos; }
+    size_t getSize() const { return size; }
+    size_t remaining() const { return size - pos; }
+    const uint8_t* getData() const { return data; }
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t pos;
+    uint64_t base_offset;
+};
+
+#endif /* BUFFER_READER_HPP */
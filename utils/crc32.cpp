@@ -0,0 +1,192 @@
+#include "crc32.hpp"
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+    #define CRC32_X86 1
+    #include <immintrin.h>
+#endif
+
+namespace {
+
+/* table[k][b] is the crc of byte b followed by k zero bytes, so eight bytes are folded per step */
+struct SlicingTables {
+    uint32_t table[8][256];
+
+    SlicingTables() {
+        for (uint32_t b = 0; b < 256; ++b) {
+            uint32_t crc = b;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+            }
+            table[0][b] = crc;
+        }
+        for (uint32_t b = 0; b < 256; ++b) {
+            for (int k = 1; k < 8; ++k) {
+                table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xff];
+            }
+        }
+    }
+};
+
+const SlicingTables& getTables() {
+    static const SlicingTables tables;
+    return tables;
+}
+
+/* works on the inverted register, like the hardware path */
+uint32_t updateSlicing8(uint32_t crc, const uint8_t* data, size_t size) {
+    const auto& t = getTables().table;
+    while (size >= 8) {
+        uint32_t low = crc ^ (static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+                              static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24);
+        crc = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^ t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^
+              t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+        data += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xff];
+    }
+    return crc;
+}
+
+/* product of two polynomials modulo the CRC polynomial, bit 31 is x^0 (reflected) */
+uint32_t multiplyModP(uint32_t a, uint32_t b) {
+    uint32_t product = 0;
+    for (uint32_t m = 1u << 31; m != 0; m >>= 1) {
+        if (a & m) {
+            product ^= b;
+        }
+        b = (b >> 1) ^ (0xEDB88320u & (0u - (b & 1)));
+    }
+    return product;
+}
+
+/* x^(2^k) mod P for k = 0..63, squaring the previous entry */
+struct PowerTable {
+    uint32_t power[64];
+
+    PowerTable() {
+        power[0] = 1u << 30; /* x^1 */
+        for (int k = 1; k < 64; ++k) {
+            power[k] = multiplyModP(power[k - 1], power[k - 1]);
+        }
+    }
+};
+
+/* x^(8 * length) mod P, the shift that appending length zero bytes applies to a crc */
+uint32_t zeroBytesOperator(uint64_t length) {
+    static const PowerTable table;
+    uint32_t result = 1u << 31; /* x^0 */
+    /* 8 * length = sum of 2^(k + 3) over the set bits k of length */
+    for (int k = 3; length != 0 && k < 64; ++k, length >>= 1) {
+        if (length & 1) {
+            result = multiplyModP(table.power[k], result);
+        }
+    }
+    return result;
+}
+
+#ifdef CRC32_X86
+
+/* folding constants for the reflected ZIP polynomial, x^n mod P for the fold distances */
+alignas(16) const uint64_t FOLD_BY_4[2] = {0x0154442bd4, 0x01c6e41596};
+alignas(16) const uint64_t FOLD_BY_1[2] = {0x01751997d0, 0x00ccaa009e};
+alignas(16) const uint64_t FOLD_TO_64[2] = {0x0163cd6124, 0x0000000000};
+alignas(16) const uint64_t BARRETT[2] = {0x01db710641, 0x01f7011641};
+
+/**
+ * fold 64-byte blocks with carry-less multiplies, then reduce to 32 bits (Barrett reduction)
+ * size must be a multiple of 16 and at least 64; works on the inverted register
+ */
+__attribute__((target("pclmul,sse4.1")))
+uint32_t updateClmul(uint32_t crc, const uint8_t* data, size_t size) {
+    auto load = [](const uint8_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); };
+
+    __m128i x1 = load(data);
+    __m128i x2 = load(data + 16);
+    __m128i x3 = load(data + 32);
+    __m128i x4 = load(data + 48);
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+    __m128i k = _mm_load_si128(reinterpret_cast<const __m128i*>(FOLD_BY_4));
+    data += 64;
+    size -= 64;
+
+    /* four independent lanes keep the multiplier busy */
+    while (size >= 64) {
+        __m128i x5 = _mm_clmulepi64_si128(x1, k, 0x00);
+        __m128i x6 = _mm_clmulepi64_si128(x2, k, 0x00);
+        __m128i x7 = _mm_clmulepi64_si128(x3, k, 0x00);
+        __m128i x8 = _mm_clmulepi64_si128(x4, k, 0x00);
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k, 0x11), x5), load(data));
+        x2 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x2, k, 0x11), x6), load(data + 16));
+        x3 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x3, k, 0x11), x7), load(data + 32));
+        x4 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x4, k, 0x11), x8), load(data + 48));
+        data += 64;
+        size -= 64;
+    }
+
+    /* fold the four lanes into one */
+    k = _mm_load_si128(reinterpret_cast<const __m128i*>(FOLD_BY_1));
+    __m128i lanes[3] = {x2, x3, x4};
+    for (const __m128i& lane : lanes) {
+        __m128i low = _mm_clmulepi64_si128(x1, k, 0x00);
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k, 0x11), lane), low);
+    }
+    while (size >= 16) {
+        __m128i low = _mm_clmulepi64_si128(x1, k, 0x00);
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k, 0x11), load(data)), low);
+        data += 16;
+        size -= 16;
+    }
+
+    /* 128 to 64 bits */
+    const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    k = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(FOLD_TO_64));
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k, 0x00), x2);
+
+    /* Barrett reduction to 32 bits */
+    k = _mm_load_si128(reinterpret_cast<const __m128i*>(BARRETT));
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k, 0x10);
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask32), k, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+bool hasClmul() {
+    static const bool supported = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+    return supported;
+}
+
+#endif /* CRC32_X86 */
+
+} /* namespace */
+
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t size) {
+    crc = ~crc;
+#ifdef CRC32_X86
+    /* below a few blocks the setup of the folding costs more than it saves */
+    if (size >= 64 && hasClmul()) {
+        size_t bulk = size & ~static_cast<size_t>(15);
+        crc = updateClmul(crc, data, bulk);
+        data += bulk;
+        size -= bulk;
+    }
+#endif
+    return ~updateSlicing8(crc, data, size);
+}
+
+uint32_t crc32Combine(uint32_t crc1, uint32_t crc2, uint64_t length2) {
+    return multiplyModP(zeroBytesOperator(length2), crc1) ^ crc2;
+}
+
+const char* crc32Implementation() {
+#ifdef CRC32_X86
+    if (hasClmul()) {
+        return "pclmul";
+    }
+#endif
+    return "slicing-by-8";
+}
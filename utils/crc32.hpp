@@ -0,0 +1,28 @@
+#ifndef CRC32_HPP
+#define CRC32_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * CRC-32 as used by ZIP (reflected polynomial 0xEDB88320)
+ * uses carry-less multiplication (PCLMULQDQ) when the CPU has it and slicing-by-8 tables otherwise
+ * @param data bytes to checksum
+ * @param size number of bytes
+ * @param crc checksum of the preceding bytes, 0 to start; chaining calls gives the checksum of the whole run
+ * @return checksum of everything so far
+ */
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t size);
+
+/**
+ * checksum of two consecutive runs from the checksums of each, without touching the data
+ * @param crc1 checksum of the first run
+ * @param crc2 checksum of the second run
+ * @param length2 length of the second run in bytes
+ */
+uint32_t crc32Combine(uint32_t crc1, uint32_t crc2, uint64_t length2);
+
+/* name of the implementation crc32Update picked on this CPU */
+const char* crc32Implementation();
+
+#endif /* CRC32_HPP */
@@ -7,6 +7,25 @@
 #define LOCAL_FILE_HEADER_SIG 0x04034b50
 #define CENTRAL_DIRECTORY_HEADER_SIG 0x02014b50
 #define END_OF_CENTRAL_DIRECTORY_SIG 0x06054b50
+#define ZIP64_END_OF_CENTRAL_DIRECTORY_SIG 0x06064b50
+#define ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIG 0x07064b50
+#define DATA_DESCRIPTOR_SIG 0x08074b50
+
+/* General purpose bit flags */
+#define GPBF_ENCRYPTED 0x0001
+#define GPBF_DATA_DESCRIPTOR 0x0008
+#define GPBF_UTF8 0x0800
+
+/* Extra field header ids */
+#define ZIP64_EXTRA_FIELD_ID 0x0001
+#define NTFS_EXTRA_FIELD_ID 0x000a
+#define EXTENDED_TIMESTAMP_EXTRA_FIELD_ID 0x5455
+#define UNICODE_PATH_EXTRA_FIELD_ID 0x7075
+#define UNIX_OWNER_EXTRA_FIELD_ID 0x7875
+
+/* value stored in a 16/32-bit field when the real value lives in a ZIP64 structure */
+#define ZIP64_ESCAPE_16 0xFFFF
+#define ZIP64_ESCAPE_32 0xFFFFFFFF
 
 static const std::string LFH_LENGTH_UNMATCH_KEY("lfh_length_unmatch");
 
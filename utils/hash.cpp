@@ -0,0 +1,83 @@
+#include "hash.hpp"
+#include "buffer_reader.hpp"
+
+namespace {
+
+const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotateLeft(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t round(uint64_t acc, uint64_t input) {
+    acc += input * PRIME2;
+    acc = rotateLeft(acc, 31);
+    return acc * PRIME1;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t value) {
+    acc ^= round(0, value);
+    return acc * PRIME1 + PRIME4;
+}
+
+} /* namespace */
+
+uint64_t hash64(const uint8_t* data, size_t size, uint64_t seed) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    uint64_t h;
+
+    if (size >= 32) {
+        uint64_t v1 = seed + PRIME1 + PRIME2;
+        uint64_t v2 = seed + PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME1;
+        const uint8_t* limit = end - 32;
+        do {
+            v1 = round(v1, loadLittleEndian<uint64_t>(p));
+            v2 = round(v2, loadLittleEndian<uint64_t>(p + 8));
+            v3 = round(v3, loadLittleEndian<uint64_t>(p + 16));
+            v4 = round(v4, loadLittleEndian<uint64_t>(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    } else {
+        h = seed + PRIME5;
+    }
+
+    h += static_cast<uint64_t>(size);
+
+    /* tail: 8, then 4, then single bytes */
+    while (p + 8 <= end) {
+        h ^= round(0, loadLittleEndian<uint64_t>(p));
+        h = rotateLeft(h, 27) * PRIME1 + PRIME4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<uint64_t>(loadLittleEndian<uint32_t>(p)) * PRIME1;
+        h = rotateLeft(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= static_cast<uint64_t>(*p) * PRIME5;
+        h = rotateLeft(h, 11) * PRIME1;
+        ++p;
+    }
+
+    /* avalanche */
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
@@ -0,0 +1,17 @@
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * 64-bit non-cryptographic hash of a byte range (the XXH64 algorithm)
+ * meant for change detection of large buffers, it runs at memory speed on four independent lanes
+ * @param data bytes to hash
+ * @param size number of bytes
+ * @param seed start value, pass the hash of a previous range to chain ranges together
+ * @return hash value
+ */
+uint64_t hash64(const uint8_t* data, size_t size, uint64_t seed = 0);
+
+#endif /* HASH_HPP */
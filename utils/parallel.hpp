@@ -0,0 +1,135 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+/* number of workers to use when the user asked for `requested`, 0 means one per hardware thread */
+inline unsigned resolveJobCount(unsigned requested) {
+    if (requested != 0) {
+        return requested;
+    }
+    unsigned hardware = std::thread::hardware_concurrency();
+    return hardware != 0 ? hardware : 1;
+}
+
+/**
+ * split [0, count) into contiguous ranges, one per worker, and run body(worker, begin, end) on each
+ * the calling thread runs the first range itself; runs inline when one worker is enough
+ */
+template<typename Body>
+void parallelForRanges(size_t count, unsigned jobs, Body body) {
+    size_t workers = std::min<size_t>(std::max(jobs, 1u), count);
+    if (workers <= 1) {
+        if (count > 0) {
+            body(0, 0, count);
+        }
+        return;
+    }
+
+    size_t chunk = count / workers;
+    size_t extra = count % workers;
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+
+    size_t begin = chunk + (extra > 0 ? 1 : 0);
+    for (size_t worker = 1; worker < workers; ++worker) {
+        size_t end = begin + chunk + (worker < extra ? 1 : 0);
+        threads.emplace_back(body, worker, begin, end);
+        begin = end;
+    }
+    body(0, 0, chunk + (extra > 0 ? 1 : 0));
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+/**
+ * run body(worker, index) for every index in [0, count), workers take the next index as they finish
+ * unlike parallelForRanges this balances items of very different cost, e.g. archive entries
+ */
+template<typename Body>
+void parallelForEach(size_t count, unsigned jobs, Body body) {
+    std::atomic<size_t> next(0);
+    size_t workers = std::min<size_t>(std::max(jobs, 1u), count);
+    parallelForRanges(workers, static_cast<unsigned>(workers), [&](size_t worker, size_t, size_t) {
+        for (size_t index = next++; index < count; index = next++) {
+            body(worker, index);
+        }
+    });
+}
+
+/**
+ * run body(worker, item) for every item of order, a work-stealing variant of parallelForEach
+ * items are dealt round-robin into one queue per worker, so with order sorted by cost every worker
+ * starts on one of the most expensive items; a worker takes from the front of its own queue and,
+ * once that is empty, steals from the back of the fullest other queue, where the cheapest items are
+ * workers only touch each other's queues while stealing, there is no shared counter to contend on
+ */
+template<typename Body>
+void parallelForEachStealing(const std::vector<size_t>& order, unsigned jobs, Body body) {
+    struct Queue {
+        std::mutex lock;
+        /* positions in the worker's share of order: worker + k * workers for front <= k < back */
+        size_t front = 0;
+        size_t back = 0;
+    };
+    size_t count = order.size();
+    size_t workers = std::min<size_t>(std::max(jobs, 1u), count);
+    if (workers <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            body(0, order[i]);
+        }
+        return;
+    }
+
+    std::unique_ptr<Queue[]> queues(new Queue[workers]);
+    for (size_t worker = 0; worker < workers; ++worker) {
+        queues[worker].back = (count - worker + workers - 1) / workers;
+    }
+    std::atomic<size_t> remaining(count);
+
+    parallelForRanges(workers, static_cast<unsigned>(workers), [&](size_t worker, size_t, size_t) {
+        while (remaining.load(std::memory_order_relaxed) > 0) {
+            size_t victim = worker;
+            size_t position = 0;
+            bool found = false;
+            {
+                std::lock_guard<std::mutex> guard(queues[worker].lock);
+                if (queues[worker].front < queues[worker].back) {
+                    position = queues[worker].front++;
+                    found = true;
+                }
+            }
+            if (!found) {
+                /* the fullest queue has the most left to give away */
+                size_t most = 0;
+                for (size_t other = 0; other < workers; ++other) {
+                    std::lock_guard<std::mutex> guard(queues[other].lock);
+                    if (queues[other].back - queues[other].front > most) {
+                        most = queues[other].back - queues[other].front;
+                        victim = other;
+                    }
+                }
+                if (most == 0) {
+                    return;
+                }
+                std::lock_guard<std::mutex> guard(queues[victim].lock);
+                if (queues[victim].front == queues[victim].back) {
+                    continue;
+                }
+                position = --queues[victim].back;
+            }
+            remaining.fetch_sub(1, std::memory_order_relaxed);
+            body(worker, order[victim + position * workers]);
+        }
+    });
+}
+
+#endif /* PARALLEL_HPP */
@@ -0,0 +1,191 @@
+#include "sig_scan.hpp"
+#include <algorithm>
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+    #define SIG_SCAN_X86 1
+    #include <immintrin.h>
+#endif
+
+namespace {
+
+/* scalar search over match starts in [0, end), from high to low */
+size_t reverseScalar(const uint8_t* data, size_t end, const uint8_t sig[4]) {
+    while (end > 0) {
+        --end;
+        if (data[end] == sig[0] && data[end + 1] == sig[1] &&
+            data[end + 2] == sig[2] && data[end + 3] == sig[3]) {
+            return end;
+        }
+    }
+    return SIG_NOT_FOUND;
+}
+
+/* scalar search over match starts in [from, end), from low to high, comparing the first width bytes */
+size_t forwardScalar(const uint8_t* data, size_t from, size_t end, const uint8_t sig[4], int width) {
+    for (size_t i = from; i < end; ++i) {
+        if (data[i] == sig[0] && data[i + 1] == sig[1] &&
+            (width == 2 || (data[i + 2] == sig[2] && data[i + 3] == sig[3]))) {
+            return i;
+        }
+    }
+    return SIG_NOT_FOUND;
+}
+
+#ifdef SIG_SCAN_X86
+
+/* forward variant of the shifted-load comparison, the last two loads are skipped for 2-byte markers */
+size_t forwardSse2(const uint8_t* data, size_t from, size_t end, const uint8_t sig[4], int width) {
+    const __m128i b0 = _mm_set1_epi8(static_cast<char>(sig[0]));
+    const __m128i b1 = _mm_set1_epi8(static_cast<char>(sig[1]));
+    const __m128i b2 = _mm_set1_epi8(static_cast<char>(sig[2]));
+    const __m128i b3 = _mm_set1_epi8(static_cast<char>(sig[3]));
+
+    while (from + 16 <= end) {
+        const uint8_t* block = data + from;
+        __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block)), b0);
+        eq = _mm_and_si128(eq, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 1)), b1));
+        if (width == 4) {
+            eq = _mm_and_si128(eq, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 2)), b2));
+            eq = _mm_and_si128(eq, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 3)), b3));
+        }
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(eq));
+        if (mask != 0) {
+            return from + __builtin_ctz(mask);
+        }
+        from += 16;
+    }
+    return forwardScalar(data, from, end, sig, width);
+}
+
+__attribute__((target("avx2")))
+size_t forwardAvx2(const uint8_t* data, size_t from, size_t end, const uint8_t sig[4], int width) {
+    const __m256i b0 = _mm256_set1_epi8(static_cast<char>(sig[0]));
+    const __m256i b1 = _mm256_set1_epi8(static_cast<char>(sig[1]));
+    const __m256i b2 = _mm256_set1_epi8(static_cast<char>(sig[2]));
+    const __m256i b3 = _mm256_set1_epi8(static_cast<char>(sig[3]));
+
+    while (from + 32 <= end) {
+        const uint8_t* block = data + from;
+        __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block)), b0);
+        eq = _mm256_and_si256(eq, _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 1)), b1));
+        if (width == 4) {
+            eq = _mm256_and_si256(eq, _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 2)), b2));
+            eq = _mm256_and_si256(eq, _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 3)), b3));
+        }
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(eq));
+        if (mask != 0) {
+            return from + __builtin_ctz(mask);
+        }
+        from += 32;
+    }
+    return forwardSse2(data, from, end, sig, width);
+}
+
+/**
+ * each block compares 16 candidate starts at once: the four signature bytes are matched
+ * against four loads shifted by one byte and the results are and-ed together
+ */
+size_t reverseSse2(const uint8_t* data, size_t end, const uint8_t sig[4]) {
+    const __m128i b0 = _mm_set1_epi8(static_cast<char>(sig[0]));
+    const __m128i b1 = _mm_set1_epi8(static_cast<char>(sig[1]));
+    const __m128i b2 = _mm_set1_epi8(static_cast<char>(sig[2]));
+    const __m128i b3 = _mm_set1_epi8(static_cast<char>(sig[3]));
+
+    while (end >= 16) {
+        const uint8_t* block = data + end - 16;
+        __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block)), b0);
+        eq = _mm_and_si128(eq, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 1)), b1));
+        eq = _mm_and_si128(eq, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 2)), b2));
+        eq = _mm_and_si128(eq, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 3)), b3));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(eq));
+        if (mask != 0) {
+            return static_cast<size_t>(block - data) + 31 - __builtin_clz(mask);
+        }
+        end -= 16;
+    }
+    return reverseScalar(data, end, sig);
+}
+
+__attribute__((target("avx2")))
+size_t reverseAvx2(const uint8_t* data, size_t end, const uint8_t sig[4]) {
+    const __m256i b0 = _mm256_set1_epi8(static_cast<char>(sig[0]));
+    const __m256i b1 = _mm256_set1_epi8(static_cast<char>(sig[1]));
+    const __m256i b2 = _mm256_set1_epi8(static_cast<char>(sig[2]));
+    const __m256i b3 = _mm256_set1_epi8(static_cast<char>(sig[3]));
+
+    while (end >= 32) {
+        const uint8_t* block = data + end - 32;
+        __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block)), b0);
+        eq = _mm256_and_si256(eq, _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 1)), b1));
+        eq = _mm256_and_si256(eq, _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 2)), b2));
+        eq = _mm256_and_si256(eq, _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 3)), b3));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(eq));
+        if (mask != 0) {
+            return static_cast<size_t>(block - data) + 31 - __builtin_clz(mask);
+        }
+        end -= 32;
+    }
+    return reverseSse2(data, end, sig);
+}
+
+bool hasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+#endif /* SIG_SCAN_X86 */
+
+size_t forwardDispatch(const uint8_t* data, size_t size, const uint8_t sig[4], int width, size_t from) {
+    /* match starts are searched in [from, end), every start needs 4 readable bytes */
+    if (size < 4 || from >= size - 3) {
+        return SIG_NOT_FOUND;
+    }
+    size_t end = size - 3;
+
+#ifdef SIG_SCAN_X86
+    if (hasAvx2()) {
+        return forwardAvx2(data, from, end, sig, width);
+    }
+    return forwardSse2(data, from, end, sig, width);
+#else
+    return forwardScalar(data, from, end, sig, width);
+#endif
+}
+
+} /* namespace */
+
+size_t findSignatureForward(const uint8_t* data, size_t size, uint32_t signature, size_t from) {
+    const uint8_t sig[4] = {
+        static_cast<uint8_t>(signature), static_cast<uint8_t>(signature >> 8),
+        static_cast<uint8_t>(signature >> 16), static_cast<uint8_t>(signature >> 24)
+    };
+    return forwardDispatch(data, size, sig, 4, from);
+}
+
+size_t findMarkerForward(const uint8_t* data, size_t size, size_t from) {
+    const uint8_t sig[4] = {'P', 'K', 0, 0};
+    return forwardDispatch(data, size, sig, 2, from);
+}
+
+size_t findSignatureReverse(const uint8_t* data, size_t size, uint32_t signature, size_t limit) {
+    if (size < 4 || limit == 0) {
+        return SIG_NOT_FOUND;
+    }
+
+    const uint8_t sig[4] = {
+        static_cast<uint8_t>(signature), static_cast<uint8_t>(signature >> 8),
+        static_cast<uint8_t>(signature >> 16), static_cast<uint8_t>(signature >> 24)
+    };
+
+    /* match starts are searched in [0, end), every start needs 4 readable bytes */
+    size_t end = std::min(size - 3, limit);
+
+#ifdef SIG_SCAN_X86
+    if (hasAvx2()) {
+        return reverseAvx2(data, end, sig);
+    }
+    return reverseSse2(data, end, sig);
+#else
+    return reverseScalar(data, end, sig);
+#endif
+}
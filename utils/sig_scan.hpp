@@ -0,0 +1,34 @@
+#ifndef SIG_SCAN_HPP
+#define SIG_SCAN_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+/* returned by the signature searches when nothing matches */
+static const size_t SIG_NOT_FOUND = static_cast<size_t>(-1);
+
+/**
+ * find the last occurrence of a 4-byte little endian signature
+ * uses AVX2 or SSE2 when available and falls back to a scalar loop otherwise
+ * @param data buffer to search
+ * @param size number of bytes in the buffer
+ * @param signature signature value as stored in the ZIP headers
+ * @param limit only matches starting strictly before limit are considered
+ * @return index of the match in the buffer, or SIG_NOT_FOUND
+ */
+size_t findSignatureReverse(const uint8_t* data, size_t size, uint32_t signature, size_t limit = SIG_NOT_FOUND);
+
+/**
+ * find the first occurrence of a 4-byte little endian signature at or after from
+ * @return index of the match in the buffer, or SIG_NOT_FOUND
+ */
+size_t findSignatureForward(const uint8_t* data, size_t size, uint32_t signature, size_t from = 0);
+
+/**
+ * find the first "PK" marker at or after from that is followed by at least two more bytes
+ * every ZIP record signature starts with this marker, so one pass finds candidates for all of them
+ * @return index of the marker in the buffer, or SIG_NOT_FOUND
+ */
+size_t findMarkerForward(const uint8_t* data, size_t size, size_t from = 0);
+
+#endif /* SIG_SCAN_HPP */
@@ -0,0 +1,79 @@
+#include "stream_buffer.hpp"
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+
+StreamBuffer::StreamBuffer(int fd, size_t capacity)
+    : fd(fd), buffer(capacity), head(0), tail(0), position(0), eof(false) {}
+
+size_t StreamBuffer::readMore() {
+    if (eof) {
+        return 0;
+    }
+    /* keep the unread bytes, move them to the front once the free space behind them runs out */
+    if (tail == buffer.size()) {
+        if (head == 0) {
+            return 0;
+        }
+        std::memmove(buffer.data(), buffer.data() + head, tail - head);
+        tail -= head;
+        head = 0;
+    }
+
+    while (true) {
+        ssize_t got = ::read(fd, buffer.data() + tail, buffer.size() - tail);
+        if (got > 0) {
+            tail += static_cast<size_t>(got);
+            return static_cast<size_t>(got);
+        }
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        /* end of stream or a read error, either way nothing more will come */
+        eof = true;
+        return 0;
+    }
+}
+
+bool StreamBuffer::fill(size_t length) {
+    if (length > buffer.size()) {
+        return false;
+    }
+    /* the request must fit behind head, make room before reading */
+    if (head + length > buffer.size()) {
+        std::memmove(buffer.data(), buffer.data() + head, tail - head);
+        tail -= head;
+        head = 0;
+    }
+    while (available() < length) {
+        if (readMore() == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void StreamBuffer::consume(size_t length) {
+    head += length;
+    position += length;
+    if (head == tail) {
+        head = 0;
+        tail = 0;
+    }
+}
+
+bool StreamBuffer::discard(uint64_t length) {
+    while (length > 0) {
+        if (available() == 0 && readMore() == 0) {
+            return false;
+        }
+        size_t step = static_cast<size_t>(length < available() ? length : available());
+        consume(step);
+        length -= step;
+    }
+    return true;
+}
+
+bool StreamBuffer::atEnd() {
+    return available() == 0 && readMore() == 0;
+}
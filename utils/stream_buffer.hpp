@@ -0,0 +1,61 @@
+#ifndef STREAM_BUFFER_HPP
+#define STREAM_BUFFER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+ * bounded read-ahead window over a forward-only file descriptor (stdin, pipes, sockets)
+ * the window never grows past its capacity: bytes before the cursor are dropped and the rest is
+ * moved to the front when more room is needed, so memory stays constant however long the stream is
+ */
+class StreamBuffer {
+public:
+    /**
+     * @param fd descriptor to read from, it is not closed by the buffer
+     * @param capacity size of the window, the largest run of bytes that can be looked at at once
+     */
+    explicit StreamBuffer(int fd, size_t capacity = DEFAULT_CAPACITY);
+
+    /* large enough for a local file header with a maximal filename and extra field */
+    static constexpr size_t DEFAULT_CAPACITY = 256 * 1024;
+
+    /**
+     * make at least length bytes available at the cursor
+     * @return false if the stream ended (or failed) first, or length exceeds the capacity
+     */
+    bool fill(size_t length);
+
+    /* bytes at the cursor, valid until the next fill */
+    const uint8_t* data() const { return buffer.data() + head; }
+    size_t available() const { return tail - head; }
+
+    /* drop length buffered bytes, length must not exceed available() */
+    void consume(size_t length);
+
+    /**
+     * move the cursor length bytes forward, reading through whatever is not buffered yet
+     * @return false if the stream ended first
+     */
+    bool discard(uint64_t length);
+
+    /* absolute stream offset of the cursor */
+    uint64_t getPosition() const { return position; }
+    size_t getCapacity() const { return buffer.size(); }
+    /* true once the producer closed its end and every byte has been consumed */
+    bool atEnd();
+
+private:
+    /* read once into the free space behind tail, returns the number of bytes read, 0 at end of stream */
+    size_t readMore();
+
+    int fd;
+    std::vector<uint8_t> buffer;
+    size_t head;
+    size_t tail;
+    uint64_t position;
+    bool eof;
+};
+
+#endif /* STREAM_BUFFER_HPP */
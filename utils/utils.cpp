@@ -6,6 +6,7 @@ template uint32_t readLittleEndian<uint32_t>(std::ifstream& file);
 
 template void writeLittleEndian(std::ofstream& file, uint32_t value);
 template void writeLittleEndian(std::ofstream& file, uint16_t value);
+template void writeLittleEndian(std::ofstream& file, uint64_t value);
 
 std::vector<std::string> splitString(const std::string& str, const std::string& delimiter) {
     std::vector<std::string> tokens;
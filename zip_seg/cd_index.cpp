@@ -0,0 +1,77 @@
+#include "cd_index.hpp"
+
+namespace {
+
+/* collect the rows for which the predicate holds, in one pass over a column */
+template<typename T, typename Predicate>
+std::vector<size_t> selectRows(const std::vector<T>& column, Predicate predicate) {
+    std::vector<size_t> rows;
+    for (size_t i = 0; i < column.size(); ++i) {
+        if (predicate(column[i])) {
+            rows.push_back(i);
+        }
+    }
+    return rows;
+}
+
+template<typename T>
+uint64_t sumColumn(const std::vector<T>& column) {
+    uint64_t total = 0;
+    for (T value : column) {
+        total += value;
+    }
+    return total;
+}
+
+} /* namespace */
+
+void CentralDirectoryIndex::build(const CompactCentralDirectory& records) {
+    clear();
+
+    size_t count = records.size();
+    crc32s.reserve(count);
+    compressed_sizes.reserve(count);
+    uncompressed_sizes.reserve(count);
+    local_header_offsets.reserve(count);
+    compression_methods.reserve(count);
+    general_bit_flags.reserve(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        CentralDirectoryRecord header = records[i];
+        crc32s.push_back(header.getCrc32());
+        compressed_sizes.push_back(header.getEffectiveCompressedSize());
+        uncompressed_sizes.push_back(header.getEffectiveUncompressedSize());
+        local_header_offsets.push_back(header.getLocalFileHeaderOffset());
+        compression_methods.push_back(header.getCompressionMethod());
+        general_bit_flags.push_back(header.getGeneralBitFlag());
+    }
+}
+
+void CentralDirectoryIndex::clear() {
+    crc32s.clear();
+    compressed_sizes.clear();
+    uncompressed_sizes.clear();
+    local_header_offsets.clear();
+    compression_methods.clear();
+    general_bit_flags.clear();
+}
+
+uint64_t CentralDirectoryIndex::totalCompressedSize() const {
+    return sumColumn(compressed_sizes);
+}
+
+uint64_t CentralDirectoryIndex::totalUncompressedSize() const {
+    return sumColumn(uncompressed_sizes);
+}
+
+std::vector<size_t> CentralDirectoryIndex::findByMethod(uint16_t method) const {
+    return selectRows(compression_methods, [method](uint16_t value) { return value == method; });
+}
+
+std::vector<size_t> CentralDirectoryIndex::findByFlag(uint16_t mask) const {
+    return selectRows(general_bit_flags, [mask](uint16_t value) { return (value & mask) != 0; });
+}
+
+std::vector<size_t> CentralDirectoryIndex::findLargerThan(uint64_t size) const {
+    return selectRows(uncompressed_sizes, [size](uint64_t value) { return value > size; });
+}
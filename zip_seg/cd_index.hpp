@@ -0,0 +1,53 @@
+#ifndef CD_INDEX_HPP
+#define CD_INDEX_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+#include "cd_record.hpp"
+
+/**
+ * structure-of-arrays copy of the central directory, built once after parsing
+ * every field lives in its own contiguous column, so scans over a single field touch only that field's
+ * memory instead of walking whole central directory records; names are not copied, the records have them
+ * sizes and offsets are the effective (ZIP64 resolved) values; row i is central directory record i
+ */
+class CentralDirectoryIndex {
+public:
+    void build(const CompactCentralDirectory& records);
+    void clear();
+
+    size_t size() const { return crc32s.size(); }
+    bool empty() const { return crc32s.empty(); }
+
+    /* ++++ columns ++++ */
+    const std::vector<uint32_t>& getCrc32s() const { return crc32s; }
+    const std::vector<uint64_t>& getCompressedSizes() const { return compressed_sizes; }
+    const std::vector<uint64_t>& getUncompressedSizes() const { return uncompressed_sizes; }
+    const std::vector<uint64_t>& getLocalHeaderOffsets() const { return local_header_offsets; }
+    const std::vector<uint16_t>& getCompressionMethods() const { return compression_methods; }
+    const std::vector<uint16_t>& getGeneralBitFlags() const { return general_bit_flags; }
+    /* ---- columns ---- */
+
+    /* ++++ queries ++++ */
+    uint64_t totalCompressedSize() const;
+    uint64_t totalUncompressedSize() const;
+    /* rows stored with the given compression method, e.g. 0 for stored, 8 for deflate */
+    std::vector<size_t> findByMethod(uint16_t method) const;
+    /* rows with any of the bits in mask set in the general purpose bit flag */
+    std::vector<size_t> findByFlag(uint16_t mask) const;
+    /* rows whose uncompressed size is strictly larger than size */
+    std::vector<size_t> findLargerThan(uint64_t size) const;
+    /* ---- queries ---- */
+
+private:
+    std::vector<uint32_t> crc32s;
+    std::vector<uint64_t> compressed_sizes;
+    std::vector<uint64_t> uncompressed_sizes;
+    std::vector<uint64_t> local_header_offsets;
+    std::vector<uint16_t> compression_methods;
+    std::vector<uint16_t> general_bit_flags;
+};
+
+#endif /* CD_INDEX_HPP */
@@ -0,0 +1,88 @@
+#include "cd_record.hpp"
+#include "defs.hpp"
+#include <algorithm>
+
+uint64_t CentralDirectoryRecord::resolveZip64(size_t slot, uint32_t value) const {
+    if (value != ZIP64_ESCAPE_32) {
+        return value;
+    }
+    ExtraRecord record;
+    if (!ExtraField(getExtraField(), getExtraFieldLength()).find(ZIP64_EXTRA_FIELD_ID, record)) {
+        return value;
+    }
+
+    /* only the escaped fields are present, always in this order */
+    Zip64ExtraField field;
+    field.decode(record, loadLittleEndian<uint32_t>(data + 24) == ZIP64_ESCAPE_32,
+                 loadLittleEndian<uint32_t>(data + 20) == ZIP64_ESCAPE_32,
+                 loadLittleEndian<uint32_t>(data + 42) == ZIP64_ESCAPE_32, false);
+    const bool present[] = {field.has_uncompressed_size, field.has_compressed_size, field.has_local_header_offset};
+    const uint64_t values[] = {field.uncompressed_size, field.compressed_size, field.local_header_offset};
+    return present[slot] ? values[slot] : value;
+}
+
+uint64_t CentralDirectoryRecord::getEffectiveUncompressedSize() const {
+    return resolveZip64(0, loadLittleEndian<uint32_t>(data + 24));
+}
+
+uint64_t CentralDirectoryRecord::getEffectiveCompressedSize() const {
+    return resolveZip64(1, loadLittleEndian<uint32_t>(data + 20));
+}
+
+uint64_t CentralDirectoryRecord::getLocalFileHeaderOffset() const {
+    return resolveZip64(2, loadLittleEndian<uint32_t>(data + 42));
+}
+
+bool CentralDirectoryRecord::decode(CentralDirectoryHeader& header) const {
+    BufferReader reader(data, getSize(), 0, offset);
+    return header.readFromBuffer(reader);
+}
+
+void CentralDirectoryRecord::print() const {
+    CentralDirectoryHeader header;
+    if (decode(header)) {
+        header.print();
+    }
+}
+
+bool CentralDirectoryRecord::writeToFile(std::ofstream& file) const {
+    if (!file.is_open() || !file.good()) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(getSize()));
+    return !file.fail();
+}
+
+bool CompactCentralDirectory::build(const uint8_t* data, size_t size, uint64_t base_offset, uint64_t count) {
+    clear();
+    this->data = data;
+    this->base_offset = base_offset;
+
+    /* every record takes at least 46 bytes, do not let a forged count reserve more than the buffer can hold */
+    record_offsets.reserve(static_cast<size_t>(std::min<uint64_t>(count, size / CentralDirectoryRecord::FIXED_SIZE)));
+    size_t pos = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (size - pos < CentralDirectoryRecord::FIXED_SIZE ||
+            loadLittleEndian<uint32_t>(data + pos) != CENTRAL_DIRECTORY_HEADER_SIG) {
+            return false;
+        }
+        size_t record_size = CentralDirectoryRecord(data + pos, 0).getSize();
+        if (size - pos < record_size) {
+            return false;
+        }
+        record_offsets.push_back(pos);
+        pos += record_size;
+    }
+    return true;
+}
+
+void CompactCentralDirectory::append(const uint8_t* record) {
+    appended_records.push_back(record);
+}
+
+void CompactCentralDirectory::clear() {
+    data = nullptr;
+    base_offset = 0;
+    record_offsets.clear();
+    appended_records.clear();
+}
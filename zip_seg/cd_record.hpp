@@ -0,0 +1,103 @@
+#ifndef CD_RECORD_HPP
+#define CD_RECORD_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <string_view>
+#include <vector>
+#include "buffer_reader.hpp"
+#include "zip_seg.hpp"
+
+/**
+ * read-only view of one central directory record in its on-disk form
+ * nothing is decoded up front: every getter reads its field from the raw bytes, so a view is two words
+ * and costs nothing until it is asked; the bytes must outlive the view
+ */
+class CentralDirectoryRecord {
+public:
+    /**
+     * @param data first byte of the record, the signature
+     * @param offset absolute file offset of the record
+     */
+    CentralDirectoryRecord(const uint8_t* data, uint64_t offset) : data(data), offset(offset) {}
+
+    /* size of the record without filename, extra field and comment */
+    static constexpr size_t FIXED_SIZE = 46;
+
+    /* ++++ get methods ++++ */
+    uint64_t getOffset() const { return offset; }
+    /* whole record, fixed part and variable-length fields */
+    size_t getSize() const { return FIXED_SIZE + getFilenameLength() + getExtraFieldLength() + getFileCommentLength(); }
+    uint16_t getGeneralBitFlag() const { return loadLittleEndian<uint16_t>(data + 8); }
+    uint16_t getCompressionMethod() const { return loadLittleEndian<uint16_t>(data + 10); }
+    uint32_t getCrc32() const { return loadLittleEndian<uint32_t>(data + 16); }
+    uint16_t getFilenameLength() const { return loadLittleEndian<uint16_t>(data + 28); }
+    uint16_t getExtraFieldLength() const { return loadLittleEndian<uint16_t>(data + 30); }
+    uint16_t getFileCommentLength() const { return loadLittleEndian<uint16_t>(data + 32); }
+    std::string_view getFilename() const {
+        return std::string_view(reinterpret_cast<const char*>(data + FIXED_SIZE), getFilenameLength());
+    }
+    const uint8_t* getExtraField() const { return data + FIXED_SIZE + getFilenameLength(); }
+    /* sizes and offset after applying the ZIP64 extra field */
+    uint64_t getEffectiveCompressedSize() const;
+    uint64_t getEffectiveUncompressedSize() const;
+    uint64_t getLocalFileHeaderOffset() const;
+    /* ---- get methods ---- */
+
+    /* decode every field into header, whose views point into the same bytes */
+    bool decode(CentralDirectoryHeader& header) const;
+    /* same output as CentralDirectoryHeader::print */
+    void print() const;
+    /* the record is written back byte for byte */
+    bool writeToFile(std::ofstream& file) const;
+
+private:
+    /* ZIP64 slot of a field: 0 uncompressed size, 1 compressed size, 2 local header offset */
+    uint64_t resolveZip64(size_t slot, uint32_t value) const;
+
+    const uint8_t* data;
+    uint64_t offset;
+};
+
+/**
+ * the central directory kept as raw bytes plus the start of every record
+ * for archives with millions of entries this stays close to the on-disk size of the directory, where
+ * decoded CentralDirectoryHeader objects would take several times as much
+ */
+class CompactCentralDirectory {
+public:
+    /**
+     * locate count records stored back to back
+     * @param data bytes of the central directory, which must outlive this object
+     * @param size number of bytes available
+     * @param base_offset absolute file offset of data[0]
+     * @return false if a record is truncated or lacks its signature
+     */
+    bool build(const uint8_t* data, size_t size, uint64_t base_offset, uint64_t count);
+    /**
+     * add the record of a new entry after the ones from the archive
+     * its place in the archive is only known once it is written, getOffset() reports 0
+     * @param record a complete record in storage that must outlive this object
+     */
+    void append(const uint8_t* record);
+    void clear();
+
+    size_t size() const { return record_offsets.size() + appended_records.size(); }
+    bool empty() const { return size() == 0; }
+    CentralDirectoryRecord operator[](size_t index) const {
+        if (index >= record_offsets.size()) {
+            return CentralDirectoryRecord(appended_records[index - record_offsets.size()], 0);
+        }
+        return CentralDirectoryRecord(data + record_offsets[index], base_offset + record_offsets[index]);
+    }
+
+private:
+    const uint8_t* data = nullptr;
+    uint64_t base_offset = 0;
+    /* relative to data */
+    std::vector<uint64_t> record_offsets;
+    std::vector<const uint8_t*> appended_records;
+};
+
+#endif /* CD_RECORD_HPP */
@@ -0,0 +1,237 @@
+#include "entry_decoder.hpp"
+#include "crc32.hpp"
+#include "defs.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+
+EntryDecoder::EntryDecoder() : stream_ready(false), write_error(0) {
+    std::memset(&stream, 0, sizeof(stream));
+}
+
+EntryDecoder::~EntryDecoder() {
+    if (stream_ready) {
+        inflateEnd(&stream);
+    }
+}
+
+const char* EntryDecoder::statusName(Status status) {
+    switch (status) {
+    case Status::OK:
+        return "ok";
+    case Status::DATA_ERROR:
+        return "corrupt compressed data";
+    case Status::READ_ERROR:
+        return "read error";
+    case Status::UNSUPPORTED_METHOD:
+        return "unsupported compression method";
+    case Status::ENCRYPTED:
+        return "encrypted";
+    case Status::SINK_STOPPED:
+        return "output stopped";
+    case Status::WRITE_ERROR:
+        return "write error";
+    }
+    return "unknown";
+}
+
+EntryDecoder::Status EntryDecoder::decode(const DataRegion& data, uint16_t method, uint16_t flags, const Sink& sink,
+                                          uint32_t& crc, uint64_t& size) {
+    crc = 0;
+    size = 0;
+    if (flags & GPBF_ENCRYPTED) {
+        return Status::ENCRYPTED;
+    }
+    if (method == 0) {
+        return decodeStored(data, sink, crc, size);
+    }
+    if (method == 8) {
+        return decodeDeflated(data, sink, crc, size);
+    }
+    return Status::UNSUPPORTED_METHOD;
+}
+
+bool EntryDecoder::readInput(const DataRegion& data, uint64_t pos, const uint8_t*& chunk, size_t& length) {
+    length = static_cast<size_t>(std::min<uint64_t>(CHUNK_SIZE, data.getSize() - pos));
+    const uint8_t* mapped = data.view();
+    if (mapped != nullptr) {
+        chunk = mapped + pos;
+        return true;
+    }
+    input.resize(CHUNK_SIZE);
+    chunk = input.data();
+    return data.read(pos, input.data(), length);
+}
+
+EntryDecoder::Status EntryDecoder::decodeStored(const DataRegion& data, const Sink& sink, uint32_t& crc,
+                                                uint64_t& size) {
+    for (uint64_t pos = 0; pos < data.getSize();) {
+        const uint8_t* chunk = nullptr;
+        size_t length = 0;
+        if (!readInput(data, pos, chunk, length)) {
+            return Status::READ_ERROR;
+        }
+        crc = crc32Update(crc, chunk, length);
+        size += length;
+        pos += length;
+        if (sink && !sink(chunk, length)) {
+            return Status::SINK_STOPPED;
+        }
+    }
+    return Status::OK;
+}
+
+EntryDecoder::Status EntryDecoder::decodeDeflated(const DataRegion& data, const Sink& sink, uint32_t& crc,
+                                                  uint64_t& size) {
+    /* raw deflate, ZIP entries carry no zlib header */
+    if (!stream_ready) {
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+            return Status::DATA_ERROR;
+        }
+        stream_ready = true;
+    } else if (inflateReset(&stream) != Z_OK) {
+        return Status::DATA_ERROR;
+    }
+    /* an earlier entry may have failed with input left over */
+    stream.next_in = nullptr;
+    stream.avail_in = 0;
+    output.resize(CHUNK_SIZE);
+
+    uint64_t pos = 0;
+    int ret = Z_OK;
+    while (ret != Z_STREAM_END) {
+        /* with all input consumed inflate may still hold output that did not fit the last window */
+        if (stream.avail_in == 0 && pos < data.getSize()) {
+            const uint8_t* chunk = nullptr;
+            size_t length = 0;
+            if (!readInput(data, pos, chunk, length)) {
+                return Status::READ_ERROR;
+            }
+            pos += length;
+            stream.next_in = const_cast<Bytef*>(chunk);
+            stream.avail_in = static_cast<uInt>(length);
+        }
+
+        stream.next_out = output.data();
+        stream.avail_out = static_cast<uInt>(output.size());
+        ret = inflate(&stream, Z_NO_FLUSH);
+        size_t produced = output.size() - stream.avail_out;
+        /* the data ended inside the deflate stream: nothing left to read and nothing more to write */
+        bool truncated = ret == Z_BUF_ERROR || (ret == Z_OK && produced == 0 && stream.avail_in == 0 &&
+                                                pos == data.getSize());
+        if ((ret != Z_OK && ret != Z_STREAM_END) || truncated) {
+            return Status::DATA_ERROR;
+        }
+        if (produced > 0) {
+            crc = crc32Update(crc, output.data(), produced);
+            size += produced;
+            if (sink && !sink(output.data(), produced)) {
+                return Status::SINK_STOPPED;
+            }
+        }
+    }
+    return Status::OK;
+}
+
+EntryDecoder::Status EntryDecoder::decodeTo(const DataRegion& data, uint16_t method, uint16_t flags, int fd,
+                                            uint32_t& crc, uint64_t& size) {
+    write_error = 0;
+    /* positioned writes need a regular file, they also leave the file position alone until the end */
+    struct stat st;
+    bool positioned = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    off_t start = positioned ? lseek(fd, 0, SEEK_CUR) : 0;
+    if (start < 0) {
+        positioned = false;
+        start = 0;
+    }
+
+    Status status;
+    if (method == 0 && !(flags & GPBF_ENCRYPTED) && data.getSource() != nullptr) {
+        crc = 0;
+        size = 0;
+        status = copyStored(data, fd, positioned, static_cast<uint64_t>(start), crc, size);
+    } else {
+        uint64_t written = 0;
+        status = decode(data, method, flags, [&](const uint8_t* chunk, size_t length) {
+            if (!writeOut(fd, positioned, static_cast<uint64_t>(start) + written, chunk, length)) {
+                return false;
+            }
+            written += length;
+            return true;
+        }, crc, size);
+        if (status == Status::SINK_STOPPED && write_error != 0) {
+            status = Status::WRITE_ERROR;
+        }
+    }
+
+    if (positioned) {
+        lseek(fd, start + static_cast<off_t>(size), SEEK_SET);
+    }
+    return status;
+}
+
+bool EntryDecoder::writeOut(int fd, bool positioned, uint64_t out_offset, const uint8_t* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = positioned ? pwrite(fd, data, length, static_cast<off_t>(out_offset)) : write(fd, data, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            write_error = n < 0 ? errno : EIO;
+            return false;
+        }
+        data += n;
+        out_offset += static_cast<uint64_t>(n);
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+EntryDecoder::Status EntryDecoder::copyStored(const DataRegion& data, int fd, bool positioned, uint64_t out_offset,
+                                              uint32_t& crc, uint64_t& size) {
+    int in_fd = data.getSource()->getFd();
+    /* cleared once the kernel refuses the copy for this pair of descriptors, the rest is written from the buffer */
+    bool kernel_copy = true;
+
+    for (uint64_t pos = 0; pos < data.getSize();) {
+        /* the window is read for the CRC anyway, it comes from the page cache the copy goes through */
+        const uint8_t* chunk = nullptr;
+        size_t length = 0;
+        if (!readInput(data, pos, chunk, length)) {
+            return Status::READ_ERROR;
+        }
+        crc = crc32Update(crc, chunk, length);
+
+        size_t done = 0;
+        while (kernel_copy && done < length) {
+            off_t in_offset = static_cast<off_t>(data.getOffset() + pos + done);
+            off_t to_offset = static_cast<off_t>(out_offset + pos + done);
+            ssize_t n = positioned ? copy_file_range(in_fd, &in_offset, fd, &to_offset, length - done, 0)
+                                   : sendfile(fd, in_fd, &in_offset, length - done);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n > 0) {
+                done += static_cast<size_t>(n);
+                continue;
+            }
+            if (n < 0 && (errno == EINVAL || errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP ||
+                          errno == EBADF)) {
+                kernel_copy = false;
+                break;
+            }
+            write_error = n < 0 ? errno : EIO;
+            return Status::WRITE_ERROR;
+        }
+        if (done < length && !writeOut(fd, positioned, out_offset + pos + done, chunk + done, length - done)) {
+            return Status::WRITE_ERROR;
+        }
+        size += length;
+        pos += length;
+    }
+    return Status::OK;
+}
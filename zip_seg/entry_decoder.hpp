@@ -0,0 +1,86 @@
+#ifndef ENTRY_DECODER_HPP
+#define ENTRY_DECODER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include <zlib.h>
+#include "zip_source.hpp"
+
+/**
+ * streams the uncompressed bytes of an entry through a sink in bounded chunks, computing the CRC-32
+ * of the output on the fly; stored (0) and deflated (8) entries are supported
+ * one decoder holds an inflate state and its buffers, reuse it for many entries on the same thread
+ */
+class EntryDecoder {
+public:
+    enum class Status {
+        OK,
+        /* the compressed data is corrupt or ends early */
+        DATA_ERROR,
+        READ_ERROR,
+        UNSUPPORTED_METHOD,
+        ENCRYPTED,
+        /* the sink asked to stop */
+        SINK_STOPPED,
+        /* the output file descriptor refused the data, see getWriteError() */
+        WRITE_ERROR
+    };
+
+    /* receives each chunk of uncompressed data, returns false to stop */
+    using Sink = std::function<bool(const uint8_t* data, size_t size)>;
+
+    EntryDecoder();
+    ~EntryDecoder();
+
+    /**
+     * decode one entry
+     * @param data the compressed file data
+     * @param method compression method from the header
+     * @param flags general purpose bit flag, encrypted entries are refused
+     * @param sink receives the output, may be empty when only the CRC is wanted
+     * @param crc CRC-32 of everything produced, also on failure
+     * @param size number of bytes produced
+     */
+    Status decode(const DataRegion& data, uint16_t method, uint16_t flags, const Sink& sink,
+                  uint32_t& crc, uint64_t& size);
+
+    /**
+     * decode one entry into a file descriptor, starting at its current position
+     * regular files are written with positioned writes and pipes or sockets with plain ones; stored
+     * entries are moved by the kernel (copy_file_range into regular files, sendfile into anything else)
+     * while the CRC-32 is taken over the same window, falling back to writes where that is refused
+     */
+    Status decodeTo(const DataRegion& data, uint16_t method, uint16_t flags, int fd, uint32_t& crc, uint64_t& size);
+
+    /* errno of the last WRITE_ERROR, EPIPE when the reader of a pipe went away */
+    int getWriteError() const { return write_error; }
+
+    static const char* statusName(Status status);
+
+    /* bytes per read and per output chunk */
+    static constexpr size_t CHUNK_SIZE = 256 * 1024;
+
+    EntryDecoder(const EntryDecoder&) = delete;
+    EntryDecoder& operator=(const EntryDecoder&) = delete;
+
+private:
+    /* next piece of compressed input: a view into the mapping, or a read into the input buffer */
+    bool readInput(const DataRegion& data, uint64_t pos, const uint8_t*& chunk, size_t& length);
+
+    Status decodeStored(const DataRegion& data, const Sink& sink, uint32_t& crc, uint64_t& size);
+    Status decodeDeflated(const DataRegion& data, const Sink& sink, uint32_t& crc, uint64_t& size);
+    Status copyStored(const DataRegion& data, int fd, bool positioned, uint64_t out_offset, uint32_t& crc,
+                      uint64_t& size);
+    /* write all of a buffer at out_offset (positioned) or at the current position, false on error */
+    bool writeOut(int fd, bool positioned, uint64_t out_offset, const uint8_t* data, size_t length);
+
+    z_stream stream;
+    bool stream_ready;
+    int write_error;
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> output;
+};
+
+#endif /* ENTRY_DECODER_HPP */
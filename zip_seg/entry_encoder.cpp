@@ -0,0 +1,265 @@
+#include "entry_encoder.hpp"
+#include "buffer_reader.hpp"
+#include "crc32.hpp"
+#include "defs.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+namespace {
+
+/* made by: UNIX, specification 6.3 */
+const uint16_t VERSION_MADE_BY = (3 << 8) | 63;
+
+bool readFully(int fd, uint64_t offset, uint8_t* buffer, size_t length) {
+    while (length > 0) {
+        ssize_t n = pread(fd, buffer, length, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        buffer += n;
+        offset += static_cast<uint64_t>(n);
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool writeFully(int fd, uint64_t offset, const uint8_t* buffer, size_t length) {
+    while (length > 0) {
+        ssize_t n = pwrite(fd, buffer, length, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        buffer += n;
+        offset += static_cast<uint64_t>(n);
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+uint16_t versionNeeded(const NewEntry& entry, bool zip64) {
+    if (zip64) {
+        return 45;
+    }
+    bool directory = !entry.name.empty() && entry.name.back() == '/';
+    return entry.compression_method == 8 || directory ? 20 : 10;
+}
+
+/* the 32-bit field, or the escape that sends readers to the ZIP64 extra field */
+uint32_t escape32(uint64_t value) {
+    return value >= ZIP64_ESCAPE_32 ? ZIP64_ESCAPE_32 : static_cast<uint32_t>(value);
+}
+
+} /* namespace */
+
+void encodeLocalFileHeader(const NewEntry& entry, std::vector<uint8_t>& out) {
+    /* the local ZIP64 field always carries both sizes */
+    bool zip64 = entry.compressed_size >= ZIP64_ESCAPE_32 || entry.uncompressed_size >= ZIP64_ESCAPE_32;
+    size_t extra_length = zip64 ? 4 + 16 : 0;
+    out.assign(30 + entry.name.size() + extra_length, 0);
+
+    uint8_t* p = out.data();
+    storeLittleEndian<uint32_t>(p, LOCAL_FILE_HEADER_SIG);
+    storeLittleEndian<uint16_t>(p + 4, versionNeeded(entry, zip64));
+    storeLittleEndian<uint16_t>(p + 6, entry.general_bit_flag);
+    storeLittleEndian<uint16_t>(p + 8, entry.compression_method);
+    storeLittleEndian<uint16_t>(p + 10, entry.last_mod_time);
+    storeLittleEndian<uint16_t>(p + 12, entry.last_mod_date);
+    storeLittleEndian<uint32_t>(p + 14, entry.crc32);
+    storeLittleEndian<uint32_t>(p + 18, zip64 ? ZIP64_ESCAPE_32 : static_cast<uint32_t>(entry.compressed_size));
+    storeLittleEndian<uint32_t>(p + 22, zip64 ? ZIP64_ESCAPE_32 : static_cast<uint32_t>(entry.uncompressed_size));
+    storeLittleEndian<uint16_t>(p + 26, static_cast<uint16_t>(entry.name.size()));
+    storeLittleEndian<uint16_t>(p + 28, static_cast<uint16_t>(extra_length));
+    std::memcpy(p + 30, entry.name.data(), entry.name.size());
+
+    if (zip64) {
+        uint8_t* extra = p + 30 + entry.name.size();
+        storeLittleEndian<uint16_t>(extra, ZIP64_EXTRA_FIELD_ID);
+        storeLittleEndian<uint16_t>(extra + 2, 16);
+        storeLittleEndian<uint64_t>(extra + 4, entry.uncompressed_size);
+        storeLittleEndian<uint64_t>(extra + 12, entry.compressed_size);
+    }
+}
+
+void encodeCentralDirectoryHeader(const NewEntry& entry, std::vector<uint8_t>& out) {
+    /* only the escaped values go into the ZIP64 field, in the order of the specification */
+    std::vector<uint64_t> zip64_values;
+    for (uint64_t value : {entry.uncompressed_size, entry.compressed_size, entry.local_header_offset}) {
+        if (value >= ZIP64_ESCAPE_32) {
+            zip64_values.push_back(value);
+        }
+    }
+    bool zip64 = !zip64_values.empty();
+    size_t extra_length = zip64 ? 4 + 8 * zip64_values.size() : 0;
+    out.assign(46 + entry.name.size() + extra_length, 0);
+
+    uint8_t* p = out.data();
+    storeLittleEndian<uint32_t>(p, CENTRAL_DIRECTORY_HEADER_SIG);
+    storeLittleEndian<uint16_t>(p + 4, VERSION_MADE_BY);
+    storeLittleEndian<uint16_t>(p + 6, versionNeeded(entry, zip64));
+    storeLittleEndian<uint16_t>(p + 8, entry.general_bit_flag);
+    storeLittleEndian<uint16_t>(p + 10, entry.compression_method);
+    storeLittleEndian<uint16_t>(p + 12, entry.last_mod_time);
+    storeLittleEndian<uint16_t>(p + 14, entry.last_mod_date);
+    storeLittleEndian<uint32_t>(p + 16, entry.crc32);
+    storeLittleEndian<uint32_t>(p + 20, escape32(entry.compressed_size));
+    storeLittleEndian<uint32_t>(p + 24, escape32(entry.uncompressed_size));
+    storeLittleEndian<uint16_t>(p + 28, static_cast<uint16_t>(entry.name.size()));
+    storeLittleEndian<uint16_t>(p + 30, static_cast<uint16_t>(extra_length));
+    /* comment length, disk number start and internal attributes stay 0 */
+    storeLittleEndian<uint32_t>(p + 38, entry.external_attr);
+    storeLittleEndian<uint32_t>(p + 42, escape32(entry.local_header_offset));
+    std::memcpy(p + 46, entry.name.data(), entry.name.size());
+
+    if (zip64) {
+        uint8_t* extra = p + 46 + entry.name.size();
+        storeLittleEndian<uint16_t>(extra, ZIP64_EXTRA_FIELD_ID);
+        storeLittleEndian<uint16_t>(extra + 2, static_cast<uint16_t>(8 * zip64_values.size()));
+        for (size_t i = 0; i < zip64_values.size(); ++i) {
+            storeLittleEndian<uint64_t>(extra + 4 + 8 * i, zip64_values[i]);
+        }
+    }
+}
+
+EntryEncoder::EntryEncoder(int level) : level(level) {}
+
+EntryEncoder::~EntryEncoder() {
+    for (auto& worker : workers) {
+        if (worker->ready) {
+            deflateEnd(&worker->stream);
+        }
+    }
+}
+
+bool EntryEncoder::compressBlock(Worker& worker, int in_fd, uint64_t begin, uint64_t end, bool last,
+                                 std::vector<uint8_t>& output, uint32_t& crc) {
+    if (!worker.ready) {
+        std::memset(&worker.stream, 0, sizeof(worker.stream));
+        /* raw deflate, ZIP entries carry no zlib header */
+        if (deflateInit2(&worker.stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return false;
+        }
+        worker.ready = true;
+    } else if (deflateReset(&worker.stream) != Z_OK) {
+        return false;
+    }
+
+    /* the window before the block is read along with it and handed to deflate as dictionary */
+    size_t dictionary = static_cast<size_t>(std::min<uint64_t>(DICTIONARY_SIZE, begin));
+    size_t length = static_cast<size_t>(end - begin);
+    worker.input.resize(dictionary + length);
+    if (!readFully(in_fd, begin - dictionary, worker.input.data(), worker.input.size())) {
+        return false;
+    }
+    crc = crc32Update(0, worker.input.data() + dictionary, length);
+    if (dictionary > 0 &&
+        deflateSetDictionary(&worker.stream, worker.input.data(), static_cast<uInt>(dictionary)) != Z_OK) {
+        return false;
+    }
+
+    /* room for the worst case plus the empty stored block of the sync flush */
+    output.resize(deflateBound(&worker.stream, static_cast<uLong>(length)) + 16);
+    worker.stream.next_in = worker.input.data() + dictionary;
+    worker.stream.avail_in = static_cast<uInt>(length);
+    worker.stream.next_out = output.data();
+    worker.stream.avail_out = static_cast<uInt>(output.size());
+    /* a sync flush ends the block on a byte boundary without marking it final, so the next one can follow */
+    int ret = deflate(&worker.stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+    if (ret != (last ? Z_STREAM_END : Z_OK) || worker.stream.avail_in != 0) {
+        return false;
+    }
+    output.resize(output.size() - worker.stream.avail_out);
+    return true;
+}
+
+bool EntryEncoder::copyStored(int in_fd, uint64_t size, int out_fd, uint64_t out_offset) {
+    uint64_t pos = 0;
+    while (pos < size) {
+        off_t in_offset = static_cast<off_t>(pos);
+        off_t to_offset = static_cast<off_t>(out_offset + pos);
+        ssize_t n = copy_file_range(in_fd, &in_offset, out_fd, &to_offset, static_cast<size_t>(size - pos), 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        pos += static_cast<uint64_t>(n);
+    }
+
+    /* the kernel refused the copy (e.g. across filesystems on older kernels), go through a buffer */
+    std::vector<uint8_t> buffer(BLOCK_SIZE);
+    while (pos < size) {
+        size_t length = static_cast<size_t>(std::min<uint64_t>(buffer.size(), size - pos));
+        if (!readFully(in_fd, pos, buffer.data(), length) ||
+            !writeFully(out_fd, out_offset + pos, buffer.data(), length)) {
+            return false;
+        }
+        pos += length;
+    }
+    return true;
+}
+
+bool EntryEncoder::encode(int in_fd, uint64_t size, int out_fd, uint64_t out_offset, unsigned jobs,
+                          Result& result) {
+    result = {0, 0, 0, size};
+    if (size == 0) {
+        return true;
+    }
+
+    unsigned worker_count = std::max(jobs, 1u);
+    while (workers.size() < worker_count) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+
+    /* a batch keeps every worker busy for a while and bounds what is held in memory */
+    uint64_t block_count = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    size_t batch_size = static_cast<size_t>(std::min<uint64_t>(block_count, worker_count * 8));
+    std::vector<std::vector<uint8_t>> outputs(batch_size);
+    std::vector<uint32_t> crcs(batch_size);
+    uint64_t written = 0;
+
+    for (uint64_t first = 0; first < block_count; first += batch_size) {
+        size_t count = static_cast<size_t>(std::min<uint64_t>(batch_size, block_count - first));
+        std::atomic<bool> failed(false);
+        parallelForEach(count, worker_count, [&](size_t worker, size_t k) {
+            uint64_t block = first + k;
+            uint64_t begin = block * BLOCK_SIZE;
+            uint64_t end = std::min<uint64_t>(size, begin + BLOCK_SIZE);
+            if (!compressBlock(*workers[worker], in_fd, begin, end, block + 1 == block_count, outputs[k], crcs[k])) {
+                failed.store(true, std::memory_order_relaxed);
+            }
+        });
+        if (failed.load()) {
+            return false;
+        }
+
+        for (size_t k = 0; k < count; ++k) {
+            uint64_t block = first + k;
+            uint64_t length = std::min<uint64_t>(size, (block + 1) * BLOCK_SIZE) - block * BLOCK_SIZE;
+            result.crc32 = crc32Combine(result.crc32, crcs[k], length);
+            if (!writeFully(out_fd, out_offset + written, outputs[k].data(), outputs[k].size())) {
+                return false;
+            }
+            written += outputs[k].size();
+        }
+    }
+
+    /* incompressible data is stored, like every zip tool does */
+    if (written >= size) {
+        result.compressed_size = size;
+        return copyStored(in_fd, size, out_fd, out_offset);
+    }
+    result.compression_method = 8;
+    result.compressed_size = written;
+    return true;
+}
@@ -0,0 +1,88 @@
+#ifndef ENTRY_ENCODER_HPP
+#define ENTRY_ENCODER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+/* everything the headers of a new entry are built from */
+struct NewEntry {
+    std::string name;
+    uint16_t compression_method = 0;
+    uint16_t general_bit_flag = 0;
+    uint16_t last_mod_time = 0;
+    uint16_t last_mod_date = 0;
+    uint32_t crc32 = 0;
+    uint64_t compressed_size = 0;
+    uint64_t uncompressed_size = 0;
+    uint64_t local_header_offset = 0;
+    /* unix mode in the upper 16 bits, MS-DOS attributes in the lower ones */
+    uint32_t external_attr = 0;
+};
+
+/**
+ * serialize the local file header of a new entry, with a ZIP64 extra field when its sizes need one
+ * @param out receives the header, filename and extra field
+ */
+void encodeLocalFileHeader(const NewEntry& entry, std::vector<uint8_t>& out);
+/* serialize the central directory header, with a ZIP64 extra field for sizes or offsets that need one */
+void encodeCentralDirectoryHeader(const NewEntry& entry, std::vector<uint8_t>& out);
+
+/**
+ * compresses file data into raw DEFLATE the way pigz does: the input is cut into independent blocks
+ * that workers compress at the same time, each primed with the 32KiB before it as dictionary and ended
+ * on a byte boundary with a sync flush, so the concatenated blocks form one ordinary deflate stream
+ * the CRC-32 of every block is taken while it is compressed and the block CRCs are combined in order
+ * one encoder keeps a deflate state and buffers per worker, reuse it for many files
+ */
+class EntryEncoder {
+public:
+    struct Result {
+        /* 8 if deflate saved space, otherwise 0 and the data was stored as is */
+        uint16_t compression_method;
+        uint32_t crc32;
+        uint64_t compressed_size;
+        uint64_t uncompressed_size;
+    };
+
+    explicit EntryEncoder(int level = Z_DEFAULT_COMPRESSION);
+    ~EntryEncoder();
+
+    /**
+     * compress size bytes read from in_fd into out_fd
+     * blocks are written in order with positioned writes starting at out_offset; only a bounded
+     * batch of blocks is in memory at a time, whatever the size of the file
+     * @param jobs number of workers compressing blocks
+     * @return false on a read, write or zlib error
+     */
+    bool encode(int in_fd, uint64_t size, int out_fd, uint64_t out_offset, unsigned jobs, Result& result);
+
+    /* input bytes per block, as in pigz */
+    static constexpr size_t BLOCK_SIZE = 128 * 1024;
+    /* deflate window carried from one block into the next */
+    static constexpr size_t DICTIONARY_SIZE = 32 * 1024;
+
+    EntryEncoder(const EntryEncoder&) = delete;
+    EntryEncoder& operator=(const EntryEncoder&) = delete;
+
+private:
+    struct Worker {
+        z_stream stream;
+        bool ready = false;
+        std::vector<uint8_t> input;
+    };
+
+    /* compress the block [begin, end) of in_fd into output, the last block finishes the stream */
+    bool compressBlock(Worker& worker, int in_fd, uint64_t begin, uint64_t end, bool last,
+                       std::vector<uint8_t>& output, uint32_t& crc);
+    /* copy size bytes of in_fd into out_fd unchanged */
+    bool copyStored(int in_fd, uint64_t size, int out_fd, uint64_t out_offset);
+
+    int level;
+    std::vector<std::unique_ptr<Worker>> workers;
+};
+
+#endif /* ENTRY_ENCODER_HPP */
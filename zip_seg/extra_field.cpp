@@ -0,0 +1,214 @@
+#include "extra_field.hpp"
+#include "buffer_reader.hpp"
+#include "defs.hpp"
+#include <ctime>
+#include <iostream>
+
+namespace {
+
+/* seconds between 1601-01-01 (FILETIME epoch) and 1970-01-01 */
+constexpr uint64_t FILETIME_UNIX_OFFSET = 11644473600ULL;
+
+void printUnixTime(const char* label, int64_t seconds) {
+    std::time_t time = static_cast<std::time_t>(seconds);
+    std::tm utc;
+    char text[32] = "invalid";
+    if (gmtime_r(&time, &utc) != nullptr) {
+        std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S UTC", &utc);
+    }
+    std::cout << "    " << label << ": " << seconds << " (" << text << ")" << std::endl;
+}
+
+void printFiletime(const char* label, uint64_t ticks) {
+    printUnixTime(label, static_cast<int64_t>(ticks / 10000000) - static_cast<int64_t>(FILETIME_UNIX_OFFSET));
+}
+
+/* little endian id of 1 to 8 bytes */
+bool readVariableId(BufferReader& reader, uint64_t& id) {
+    uint8_t size = 0;
+    const uint8_t* bytes = nullptr;
+    if (!reader.read(size) || size > 8 || !reader.readBytes(size, bytes)) {
+        return false;
+    }
+    id = 0;
+    for (uint8_t i = 0; i < size; ++i) {
+        id |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+    }
+    return true;
+}
+
+} /* namespace */
+
+void ExtraField::Iterator::load() {
+    if (pos >= length || length - pos < 4) {
+        pos = length;
+        return;
+    }
+    record.id = loadLittleEndian<uint16_t>(data + pos);
+    record.size = loadLittleEndian<uint16_t>(data + pos + 2);
+    record.data = data + pos + 4;
+    if (record.size > length - pos - 4) {
+        pos = length;
+    }
+}
+
+bool ExtraField::find(uint16_t id, ExtraRecord& record) const {
+    for (const ExtraRecord& candidate : *this) {
+        if (candidate.id == id) {
+            record = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ExtraField::isValid() const {
+    /* walk the records by hand, the iterator hides where it stopped */
+    size_t pos = 0;
+    while (length - pos >= 4) {
+        size_t size = loadLittleEndian<uint16_t>(data + pos + 2);
+        if (size > length - pos - 4) {
+            return false;
+        }
+        pos += 4 + size;
+    }
+    return pos == length;
+}
+
+void ExtraField::print() const {
+    for (const ExtraRecord& record : *this) {
+        std::cout << "  Extra Field 0x" << std::hex << record.id << std::dec;
+        switch (record.id) {
+        case ZIP64_EXTRA_FIELD_ID: {
+            std::cout << " ZIP64 Extended Information (" << record.size << " bytes)" << std::endl;
+            /* which values are present depends on the header, show the 64-bit ones as they come */
+            BufferReader reader(record.data, record.size);
+            uint64_t value = 0;
+            while (reader.read(value)) {
+                std::cout << "    Value: " << value << std::endl;
+            }
+            break;
+        }
+        case EXTENDED_TIMESTAMP_EXTRA_FIELD_ID: {
+            std::cout << " Extended Timestamp (" << record.size << " bytes)" << std::endl;
+            ExtendedTimestampExtraField field;
+            if (!field.decode(record)) {
+                std::cout << "    Malformed" << std::endl;
+                break;
+            }
+            if (field.has_mtime) {
+                printUnixTime("Modification Time", field.mtime);
+            }
+            if (field.has_atime) {
+                printUnixTime("Access Time", field.atime);
+            }
+            if (field.has_ctime) {
+                printUnixTime("Creation Time", field.ctime);
+            }
+            break;
+        }
+        case UNIX_OWNER_EXTRA_FIELD_ID: {
+            std::cout << " Unix Owner (" << record.size << " bytes)" << std::endl;
+            UnixOwnerExtraField field;
+            if (!field.decode(record)) {
+                std::cout << "    Malformed" << std::endl;
+                break;
+            }
+            std::cout << "    UID: " << field.uid << std::endl;
+            std::cout << "    GID: " << field.gid << std::endl;
+            break;
+        }
+        case UNICODE_PATH_EXTRA_FIELD_ID: {
+            std::cout << " Unicode Path (" << record.size << " bytes)" << std::endl;
+            UnicodePathExtraField field;
+            if (!field.decode(record)) {
+                std::cout << "    Malformed" << std::endl;
+                break;
+            }
+            std::cout << "    Name CRC32: 0x" << std::hex << field.name_crc32 << std::dec << std::endl;
+            std::cout << "    Path: " << field.name << std::endl;
+            break;
+        }
+        case NTFS_EXTRA_FIELD_ID: {
+            std::cout << " NTFS (" << record.size << " bytes)" << std::endl;
+            NtfsExtraField field;
+            if (!field.decode(record)) {
+                std::cout << "    Malformed" << std::endl;
+                break;
+            }
+            if (field.has_times) {
+                printFiletime("Modification Time", field.mtime);
+                printFiletime("Access Time", field.atime);
+                printFiletime("Creation Time", field.ctime);
+            }
+            break;
+        }
+        default:
+            std::cout << " (" << record.size << " bytes)" << std::endl;
+            break;
+        }
+    }
+    if (!isValid()) {
+        std::cout << "  Extra Field: trailing bytes do not form a complete record" << std::endl;
+    }
+}
+
+bool Zip64ExtraField::decode(const ExtraRecord& record, bool uncompressed, bool compressed, bool offset, bool disk) {
+    BufferReader reader(record.data, record.size);
+    has_uncompressed_size = uncompressed && reader.read(uncompressed_size);
+    has_compressed_size = compressed && reader.read(compressed_size);
+    has_local_header_offset = offset && reader.read(local_header_offset);
+    has_disk_number_start = disk && reader.read(disk_number_start);
+    return has_uncompressed_size == uncompressed && has_compressed_size == compressed &&
+           has_local_header_offset == offset && has_disk_number_start == disk;
+}
+
+bool ExtendedTimestampExtraField::decode(const ExtraRecord& record) {
+    BufferReader reader(record.data, record.size);
+    if (!reader.read(flags)) {
+        return false;
+    }
+    /* the flags describe the local copy, the central one may stop after the modification time */
+    has_mtime = (flags & 0x01) && reader.read(mtime);
+    has_atime = (flags & 0x02) && reader.read(atime);
+    has_ctime = (flags & 0x04) && reader.read(ctime);
+    return true;
+}
+
+bool UnixOwnerExtraField::decode(const ExtraRecord& record) {
+    BufferReader reader(record.data, record.size);
+    return reader.read(version) && readVariableId(reader, uid) && readVariableId(reader, gid);
+}
+
+bool UnicodePathExtraField::decode(const ExtraRecord& record) {
+    BufferReader reader(record.data, record.size);
+    if (!reader.read(version) || !reader.read(name_crc32)) {
+        return false;
+    }
+    name = std::string_view(reinterpret_cast<const char*>(record.data + 5), record.size - 5);
+    return true;
+}
+
+bool NtfsExtraField::decode(const ExtraRecord& record) {
+    BufferReader reader(record.data, record.size);
+    uint32_t reserved = 0;
+    if (!reader.read(reserved)) {
+        return false;
+    }
+    /* a list of tagged attributes, only tag 1 (times) is defined */
+    uint16_t tag = 0;
+    uint16_t size = 0;
+    while (reader.read(tag) && reader.read(size)) {
+        const uint8_t* attribute = nullptr;
+        if (!reader.readBytes(size, attribute)) {
+            return false;
+        }
+        if (tag == 1 && size >= 24) {
+            has_times = true;
+            mtime = loadLittleEndian<uint64_t>(attribute);
+            atime = loadLittleEndian<uint64_t>(attribute + 8);
+            ctime = loadLittleEndian<uint64_t>(attribute + 16);
+        }
+    }
+    return true;
+}
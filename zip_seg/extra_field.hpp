@@ -0,0 +1,125 @@
+#ifndef EXTRA_FIELD_HPP
+#define EXTRA_FIELD_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+/* one header id / size record of an extra field, data points into the header bytes */
+struct ExtraRecord {
+    uint16_t id;
+    uint16_t size;
+    const uint8_t* data;
+};
+
+/**
+ * walks the records of an extra field in place
+ * iteration stops at the first record whose declared size runs past the field; isValid tells
+ * whether the whole field was consumed cleanly, nothing is allocated or copied
+ */
+class ExtraField {
+public:
+    ExtraField(const uint8_t* data, uint16_t length) : data(data), length(data == nullptr ? 0 : length) {}
+
+    class Iterator {
+    public:
+        Iterator(const uint8_t* data, size_t length, size_t pos) : data(data), length(length), pos(pos) { load(); }
+        const ExtraRecord& operator*() const { return record; }
+        const ExtraRecord* operator->() const { return &record; }
+        Iterator& operator++() {
+            pos += 4 + record.size;
+            load();
+            return *this;
+        }
+        bool operator!=(const Iterator& other) const { return pos != other.pos; }
+
+    private:
+        /* decode the record at pos, or move to the end if it does not fit */
+        void load();
+
+        const uint8_t* data;
+        size_t length;
+        size_t pos;
+        ExtraRecord record = {0, 0, nullptr};
+    };
+
+    Iterator begin() const { return Iterator(data, length, 0); }
+    Iterator end() const { return Iterator(data, length, length); }
+
+    /* first record with this header id */
+    bool find(uint16_t id, ExtraRecord& record) const;
+    /* false if a record is truncated or bytes are left over that cannot form a record */
+    bool isValid() const;
+    /* print every record, decoded where the type is known */
+    void print() const;
+
+private:
+    const uint8_t* data;
+    size_t length;
+};
+
+/* ++++ typed decoders, each returns false if the record is too short for what it claims ++++ */
+
+/**
+ * 0x0001 ZIP64 extended information
+ * only the fields escaped in the header are present, in this order; pass which ones to expect
+ */
+struct Zip64ExtraField {
+    uint64_t uncompressed_size = 0;
+    uint64_t compressed_size = 0;
+    uint64_t local_header_offset = 0;
+    uint32_t disk_number_start = 0;
+    /* which of the above were present */
+    bool has_uncompressed_size = false;
+    bool has_compressed_size = false;
+    bool has_local_header_offset = false;
+    bool has_disk_number_start = false;
+
+    bool decode(const ExtraRecord& record, bool uncompressed, bool compressed, bool offset, bool disk);
+};
+
+/* 0x5455 extended timestamp, Unix seconds; the central copy usually only carries the modification time */
+struct ExtendedTimestampExtraField {
+    uint8_t flags = 0;
+    bool has_mtime = false;
+    bool has_atime = false;
+    bool has_ctime = false;
+    uint32_t mtime = 0;
+    uint32_t atime = 0;
+    uint32_t ctime = 0;
+
+    bool decode(const ExtraRecord& record);
+};
+
+/* 0x7875 Info-ZIP Unix owner, variable-width ids of up to 8 bytes */
+struct UnixOwnerExtraField {
+    uint8_t version = 0;
+    uint64_t uid = 0;
+    uint64_t gid = 0;
+
+    bool decode(const ExtraRecord& record);
+};
+
+/* 0x7075 Info-ZIP Unicode path, name is valid while the header bytes are */
+struct UnicodePathExtraField {
+    uint8_t version = 0;
+    /* crc32 of the header filename this path replaces, stale if the name was changed without it */
+    uint32_t name_crc32 = 0;
+    std::string_view name;
+
+    bool decode(const ExtraRecord& record);
+};
+
+/* 0x000a NTFS attribute tag 1: FILETIME values, 100 ns ticks since 1601-01-01 */
+struct NtfsExtraField {
+    bool has_times = false;
+    uint64_t mtime = 0;
+    uint64_t atime = 0;
+    uint64_t ctime = 0;
+
+    bool decode(const ExtraRecord& record);
+};
+
+/* ---- typed decoders ---- */
+
+#endif /* EXTRA_FIELD_HPP */
@@ -0,0 +1,32 @@
+#include "io_planner.hpp"
+#include <algorithm>
+
+void IoPlanner::plan(uint64_t file_size) {
+    /* stable so that duplicate offsets keep central directory order */
+    std::stable_sort(requests.begin(), requests.end(), [](const ReadRequest& a, const ReadRequest& b) {
+        return a.offset < b.offset;
+    });
+
+    batches.clear();
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const ReadRequest& request = requests[i];
+        if (request.offset >= file_size) {
+            /* everything after this one is out of the file as well */
+            break;
+        }
+        uint64_t end = std::min(file_size, request.offset + request.length);
+
+        if (!batches.empty()) {
+            ReadBatch& batch = batches.back();
+            uint64_t batch_end = batch.offset + batch.length;
+            /* overlapping or close enough that reading the gap is cheaper than another seek */
+            bool close = request.offset <= batch_end || request.offset - batch_end <= max_gap;
+            if (close && std::max(batch_end, end) - batch.offset <= max_batch_size) {
+                batch.length = std::max(batch_end, end) - batch.offset;
+                batch.last = i + 1;
+                continue;
+            }
+        }
+        batches.push_back({request.offset, end - request.offset, i, i + 1});
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef IO_PLANNER_HPP
+#define IO_PLANNER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/* one small read the parser wants to issue, index identifies the caller's slot */
+struct ReadRequest {
+    uint64_t offset;
+    uint64_t length;
+    size_t index;
+};
+
+/* one large sequential read covering requests [first, last) of the sorted request list */
+struct ReadBatch {
+    uint64_t offset;
+    uint64_t length;
+    size_t first;
+    size_t last;
+};
+
+/**
+ * turns scattered header reads into a streaming schedule
+ * requests are sorted by offset and neighbours closer than max_gap are merged into one read,
+ * as long as the merged read stays below max_batch_size
+ */
+class IoPlanner {
+public:
+    IoPlanner(uint64_t max_gap, uint64_t max_batch_size)
+        : max_gap(max_gap), max_batch_size(max_batch_size) {}
+
+    void reserve(size_t count) { requests.reserve(count); }
+    void addRequest(uint64_t offset, uint64_t length, size_t index) {
+        requests.push_back({offset, length, index});
+    }
+
+    /**
+     * sort and coalesce the requests, reads are clipped to the end of the file
+     * requests starting at or past file_size get no batch and are left to the caller
+     */
+    void plan(uint64_t file_size);
+
+    const std::vector<ReadRequest>& getRequests() const { return requests; }
+    const std::vector<ReadBatch>& getBatches() const { return batches; }
+
+private:
+    uint64_t max_gap;
+    uint64_t max_batch_size;
+    std::vector<ReadRequest> requests;
+    std::vector<ReadBatch> batches;
+};
+
+#endif /* IO_PLANNER_HPP */
@@ -0,0 +1,94 @@
+#include "name_index.hpp"
+#include "hash.hpp"
+#include <algorithm>
+
+namespace {
+
+uint64_t hashName(std::string_view name) {
+    return hash64(reinterpret_cast<const uint8_t*>(name.data()), name.size());
+}
+
+} /* namespace */
+
+void FilenameIndex::build(const std::vector<std::string_view>& names) {
+    clear();
+    this->names = names;
+
+    /* keep the load factor at or below one half so probe sequences stay short */
+    size_t capacity = 16;
+    while (capacity < names.size() * 2) {
+        capacity <<= 1;
+    }
+    mask = capacity - 1;
+    slots.assign(capacity, 0);
+    slot_hashes.assign(capacity, 0);
+    next_rows.assign(names.size(), NO_ROW);
+    tail_rows.assign(names.size(), NO_ROW);
+
+    for (size_t row = 0; row < names.size(); ++row) {
+        uint64_t hash = hashName(names[row]);
+        size_t slot = probe(names[row], hash);
+        if (slots[slot] == 0) {
+            slots[slot] = row + 1;
+            slot_hashes[slot] = hash;
+            tail_rows[row] = row;
+            continue;
+        }
+
+        /* same name as an earlier row: append to its chain */
+        size_t head = slots[slot] - 1;
+        if (next_rows[head] == NO_ROW) {
+            duplicate_heads.push_back(head);
+        }
+        next_rows[tail_rows[head]] = row;
+        tail_rows[head] = row;
+    }
+
+    /* heads were recorded when their second row showed up, report them in row order */
+    std::sort(duplicate_heads.begin(), duplicate_heads.end());
+}
+
+void FilenameIndex::clear() {
+    names.clear();
+    slots.clear();
+    slot_hashes.clear();
+    next_rows.clear();
+    tail_rows.clear();
+    duplicate_heads.clear();
+    mask = 0;
+}
+
+size_t FilenameIndex::probe(std::string_view name, uint64_t hash) const {
+    size_t slot = static_cast<size_t>(hash) & mask;
+    while (slots[slot] != 0) {
+        if (slot_hashes[slot] == hash && names[slots[slot] - 1] == name) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+size_t FilenameIndex::findFirst(std::string_view name) const {
+    if (slots.empty()) {
+        return NO_ROW;
+    }
+    size_t slot = probe(name, hashName(name));
+    return slots[slot] == 0 ? NO_ROW : slots[slot] - 1;
+}
+
+std::vector<size_t> FilenameIndex::find(std::string_view name) const {
+    std::vector<size_t> rows;
+    for (size_t row = findFirst(name); row != NO_ROW; row = next_rows[row]) {
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+size_t FilenameIndex::countRows(size_t head) const {
+    size_t count = 0;
+    for (size_t row = head; row != NO_ROW; row = next_rows[row]) {
+        ++count;
+    }
+    return count;
+}
@@ -0,0 +1,52 @@
+#ifndef NAME_INDEX_HPP
+#define NAME_INDEX_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+/**
+ * open-addressing hash table from filename to header rows
+ * one slot per distinct name with linear probing; rows sharing a name are chained in row order,
+ * so duplicates (a classic trick in crafted archives) cost nothing extra to find
+ * names are kept as views, the headers they point into must outlive the index
+ */
+class FilenameIndex {
+public:
+    /* row returned when nothing matches */
+    static constexpr size_t NO_ROW = static_cast<size_t>(-1);
+
+    /* index names[i] as row i, replaces any previous contents */
+    void build(const std::vector<std::string_view>& names);
+    void clear();
+
+    /* all rows with this name in ascending order, empty if there is none */
+    std::vector<size_t> find(std::string_view name) const;
+    /* first row with this name, or NO_ROW */
+    size_t findFirst(std::string_view name) const;
+
+    /* first row of every name that occurs more than once, in row order */
+    const std::vector<size_t>& getDuplicateHeads() const { return duplicate_heads; }
+    /* number of rows sharing the name of a head row */
+    size_t countRows(size_t head) const;
+    std::string_view getName(size_t row) const { return names[row]; }
+
+private:
+    /* slot that holds name, or the empty slot where it would go */
+    size_t probe(std::string_view name, uint64_t hash) const;
+
+    std::vector<std::string_view> names;
+    /* per slot: row + 1 of the first row with that name, 0 if the slot is empty */
+    std::vector<size_t> slots;
+    /* per slot: full hash of the name, compared before the bytes */
+    std::vector<uint64_t> slot_hashes;
+    /* per row: next row with the same name, NO_ROW at the end of a chain */
+    std::vector<size_t> next_rows;
+    /* per row: last row of the chain, only maintained for head rows */
+    std::vector<size_t> tail_rows;
+    std::vector<size_t> duplicate_heads;
+    size_t mask = 0;
+};
+
+#endif /* NAME_INDEX_HPP */
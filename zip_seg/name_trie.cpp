@@ -0,0 +1,262 @@
+#include "name_trie.hpp"
+#include <algorithm>
+#include <fnmatch.h>
+
+namespace {
+
+/* byte order with '/' below every other byte, so names sharing a leading component stay adjacent */
+inline int pathByte(char c) {
+    return c == '/' ? 0 : static_cast<unsigned char>(c) + 1;
+}
+
+bool pathLess(std::string_view a, std::string_view b) {
+    size_t length = std::min(a.size(), b.size());
+    for (size_t i = 0; i < length; ++i) {
+        if (a[i] != b[i]) {
+            return pathByte(a[i]) < pathByte(b[i]);
+        }
+    }
+    return a.size() < b.size();
+}
+
+/* first component of a label or path */
+std::string_view firstComponent(std::string_view path) {
+    return path.substr(0, std::min(path.find('/'), path.size()));
+}
+
+bool hasWildcard(const std::string& pattern) {
+    return pattern.find_first_of("*?[") != std::string::npos;
+}
+
+} /* namespace */
+
+void NameTrie::build(const std::vector<std::string_view>& names, const std::vector<uint64_t>& compressed_sizes,
+                     const std::vector<uint64_t>& uncompressed_sizes) {
+    clear();
+
+    /* directory entries end in '/', the trie works on the name without it */
+    std::vector<std::string_view> paths(names.size());
+    for (size_t i = 0; i < names.size(); ++i) {
+        paths[i] = names[i];
+        if (!paths[i].empty() && paths[i].back() == '/') {
+            paths[i].remove_suffix(1);
+        }
+    }
+    std::vector<size_t> order(names.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&paths](size_t a, size_t b) { return pathLess(paths[a], paths[b]); });
+
+    /* per node: sorted row range it covers and where its path ends in those names */
+    struct Pending {
+        size_t begin;
+        size_t end;
+        size_t path_end;
+    };
+    std::vector<Pending> pending;
+    nodes.push_back({std::string_view(), NO_NODE, 0, 0, 0, 0, false, 0, 0, 0});
+    pending.push_back({0, order.size(), 0});
+    node_rows.reserve(names.size());
+
+    /* breadth first, so all children of a node are appended next to each other */
+    for (size_t n = 0; n < nodes.size(); ++n) {
+        Pending range = pending[n];
+        bool root = n == 0;
+        size_t start = root ? 0 : range.path_end + 1;
+
+        /* names ending here sort first */
+        size_t i = range.begin;
+        nodes[n].row_begin = static_cast<uint32_t>(node_rows.size());
+        while (i < range.end && paths[order[i]].size() == range.path_end && (!root || paths[order[i]].empty())) {
+            node_rows.push_back(order[i]);
+            nodes[n].directory = nodes[n].directory || names[order[i]].size() != paths[order[i]].size();
+            ++i;
+        }
+        nodes[n].row_end = static_cast<uint32_t>(node_rows.size());
+
+        nodes[n].first_child = static_cast<uint32_t>(nodes.size());
+        while (i < range.end) {
+            std::string_view first = paths[order[i]];
+            std::string_view comp = firstComponent(first.substr(start));
+
+            /* the group of names continuing with the same component */
+            size_t group_end = i + 1;
+            while (group_end < range.end) {
+                std::string_view other = paths[order[group_end]];
+                if (other.size() < start + comp.size() || other.compare(start, comp.size(), comp) != 0 ||
+                    (other.size() > start + comp.size() && other[start + comp.size()] != '/')) {
+                    break;
+                }
+                ++group_end;
+            }
+
+            /* extend the label while no name ends inside it and every name continues the same way */
+            size_t label_end = start + comp.size();
+            std::string_view last = paths[order[group_end - 1]];
+            while (first.size() > label_end) {
+                std::string_view next = firstComponent(first.substr(label_end + 1));
+                size_t next_end = label_end + 1 + next.size();
+                bool shared = last.size() >= next_end && last.compare(label_end + 1, next.size(), next) == 0 &&
+                              (last.size() == next_end || last[next_end] == '/');
+                if (!shared) {
+                    break;
+                }
+                label_end = next_end;
+            }
+
+            nodes.push_back({first.substr(start, label_end - start), static_cast<uint32_t>(n), 0, 0, 0, 0, false, 0, 0, 0});
+            pending.push_back({i, group_end, label_end});
+            i = group_end;
+        }
+        nodes[n].child_count = static_cast<uint32_t>(nodes.size()) - nodes[n].first_child;
+    }
+
+    /* children come after their parent, so one backward pass sums every subtree */
+    for (size_t n = nodes.size(); n-- > 0;) {
+        Node& node = nodes[n];
+        for (uint32_t r = node.row_begin; r < node.row_end; ++r) {
+            node.entry_count++;
+            node.compressed_size += compressed_sizes[node_rows[r]];
+            node.uncompressed_size += uncompressed_sizes[node_rows[r]];
+        }
+        if (node.parent != NO_NODE) {
+            Node& parent = nodes[node.parent];
+            parent.entry_count += node.entry_count;
+            parent.compressed_size += node.compressed_size;
+            parent.uncompressed_size += node.uncompressed_size;
+        }
+    }
+}
+
+void NameTrie::clear() {
+    nodes.clear();
+    node_rows.clear();
+}
+
+bool NameTrie::findChild(const Cursor& cursor, std::string_view comp, Cursor& next) const {
+    const Node& node = nodes[cursor.node];
+    if (!atNode(cursor)) {
+        /* inside a compressed label, the only way on is the next component of the label */
+        std::string_view rest = node.label.substr(cursor.offset + 1);
+        if (firstComponent(rest) != comp) {
+            return false;
+        }
+        next = {cursor.node, cursor.offset + 1 + comp.size()};
+        return true;
+    }
+
+    /* children are sorted by label, and so by first component */
+    auto begin = nodes.begin() + node.first_child;
+    auto end = begin + node.child_count;
+    auto it = std::lower_bound(begin, end, comp, [](const Node& child, std::string_view value) {
+        return pathLess(firstComponent(child.label), value);
+    });
+    if (it == end || firstComponent(it->label) != comp) {
+        return false;
+    }
+    next = {static_cast<uint32_t>(it - nodes.begin()), comp.size()};
+    return true;
+}
+
+bool NameTrie::find(std::string_view path, Cursor& cursor) const {
+    if (nodes.empty()) {
+        return false;
+    }
+    cursor = getRoot();
+    while (!path.empty() && path.back() == '/') {
+        path.remove_suffix(1);
+    }
+    while (!path.empty()) {
+        std::string_view comp = firstComponent(path);
+        if (!findChild(cursor, comp, cursor)) {
+            return false;
+        }
+        path = comp.size() < path.size() ? path.substr(comp.size() + 1) : std::string_view();
+    }
+    return true;
+}
+
+void NameTrie::forEachChild(const Cursor& cursor,
+                            const std::function<void(std::string_view, const Cursor&)>& fn) const {
+    const Node& node = nodes[cursor.node];
+    if (!atNode(cursor)) {
+        std::string_view comp = firstComponent(node.label.substr(cursor.offset + 1));
+        fn(comp, {cursor.node, cursor.offset + 1 + comp.size()});
+        return;
+    }
+    for (uint32_t c = node.first_child; c < node.first_child + node.child_count; ++c) {
+        std::string_view comp = firstComponent(nodes[c].label);
+        fn(comp, {c, comp.size()});
+    }
+}
+
+bool NameTrie::hasChildren(const Cursor& cursor) const {
+    return !atNode(cursor) || nodes[cursor.node].child_count > 0;
+}
+
+std::vector<size_t> NameTrie::getRows(const Cursor& cursor) const {
+    std::vector<size_t> rows;
+    if (atNode(cursor)) {
+        const Node& node = nodes[cursor.node];
+        rows.assign(node_rows.begin() + node.row_begin, node_rows.begin() + node.row_end);
+    }
+    return rows;
+}
+
+std::vector<size_t> NameTrie::glob(std::string_view pattern) const {
+    std::vector<size_t> rows;
+    if (nodes.empty()) {
+        return rows;
+    }
+
+    std::vector<std::string> patterns;
+    while (!pattern.empty() && pattern.back() == '/') {
+        pattern.remove_suffix(1);
+    }
+    size_t pos = 0;
+    while (pos <= pattern.size() && !pattern.empty()) {
+        size_t end = std::min(pattern.find('/', pos), pattern.size());
+        patterns.emplace_back(pattern.substr(pos, end - pos));
+        pos = end + 1;
+    }
+
+    globFrom(getRoot(), patterns, 0, rows);
+    /* "**" can reach the same row along several routes */
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    return rows;
+}
+
+void NameTrie::globFrom(const Cursor& cursor, const std::vector<std::string>& patterns, size_t index,
+                        std::vector<size_t>& rows) const {
+    if (index == patterns.size()) {
+        std::vector<size_t> here = getRows(cursor);
+        rows.insert(rows.end(), here.begin(), here.end());
+        return;
+    }
+
+    const std::string& pattern = patterns[index];
+    if (pattern == "**") {
+        /* zero components, or one more and stay on "**" */
+        globFrom(cursor, patterns, index + 1, rows);
+        forEachChild(cursor, [&](std::string_view, const Cursor& next) {
+            globFrom(next, patterns, index, rows);
+        });
+        return;
+    }
+
+    if (!hasWildcard(pattern)) {
+        Cursor next;
+        if (findChild(cursor, pattern, next)) {
+            globFrom(next, patterns, index + 1, rows);
+        }
+        return;
+    }
+
+    forEachChild(cursor, [&](std::string_view comp, const Cursor& next) {
+        if (fnmatch(pattern.c_str(), std::string(comp).c_str(), 0) == 0) {
+            globFrom(next, patterns, index + 1, rows);
+        }
+    });
+}
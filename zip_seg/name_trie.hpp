@@ -0,0 +1,92 @@
+#ifndef NAME_TRIE_HPP
+#define NAME_TRIE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * compressed prefix tree over entry names, split at '/'
+ * a chain of directories that holds nothing but the next directory is stored as one node whose label
+ * spans several components, so deep single-file paths cost one node; the children of a node are
+ * contiguous and sorted, which makes lookups a binary search per component
+ * every node carries the entry count and byte totals of its whole subtree
+ * labels are views into the names given to build(), which must outlive the trie
+ */
+class NameTrie {
+public:
+    static constexpr uint32_t NO_NODE = static_cast<uint32_t>(-1);
+
+    struct Node {
+        /* one or more components joined by '/', empty for the root */
+        std::string_view label;
+        uint32_t parent;
+        uint32_t first_child;
+        uint32_t child_count;
+        /* rows whose name ends exactly at this node, as a range of the row list */
+        uint32_t row_begin;
+        uint32_t row_end;
+        /* true if one of those rows is an explicit directory entry (name ending in '/') */
+        bool directory;
+        /* subtree aggregates */
+        uint64_t entry_count;
+        uint64_t compressed_size;
+        uint64_t uncompressed_size;
+    };
+
+    /* position in the trie: a node and how many bytes of its label are consumed */
+    struct Cursor {
+        uint32_t node;
+        size_t offset;
+    };
+
+    /**
+     * build the trie, row i is names[i]
+     * @param names entry names, a trailing '/' marks a directory entry
+     * @param compressed_sizes compressed size of each row
+     * @param uncompressed_sizes uncompressed size of each row
+     */
+    void build(const std::vector<std::string_view>& names, const std::vector<uint64_t>& compressed_sizes,
+               const std::vector<uint64_t>& uncompressed_sizes);
+    void clear();
+    bool empty() const { return nodes.empty(); }
+
+    const Node& getNode(uint32_t index) const { return nodes[index]; }
+    Cursor getRoot() const { return {0, 0}; }
+
+    /**
+     * locate a directory, "" and "/" are the root
+     * @return false if no entry lives at or below path
+     */
+    bool find(std::string_view path, Cursor& cursor) const;
+
+    /* call fn(component, cursor) for every component directly below cursor, in sorted order */
+    void forEachChild(const Cursor& cursor, const std::function<void(std::string_view, const Cursor&)>& fn) const;
+
+    /* whether anything lies below the cursor */
+    bool hasChildren(const Cursor& cursor) const;
+    /* rows whose name ends exactly at the cursor */
+    std::vector<size_t> getRows(const Cursor& cursor) const;
+
+    /**
+     * rows whose full name matches a glob pattern, in ascending order
+     * components are matched with fnmatch, "**" matches any number of components; only subtrees
+     * that can still match are visited and literal components are looked up directly
+     */
+    std::vector<size_t> glob(std::string_view pattern) const;
+
+private:
+    /* step from cursor to the child component comp, false if there is none */
+    bool findChild(const Cursor& cursor, std::string_view comp, Cursor& next) const;
+    bool atNode(const Cursor& cursor) const { return cursor.offset == nodes[cursor.node].label.size(); }
+    void globFrom(const Cursor& cursor, const std::vector<std::string>& patterns, size_t index,
+                  std::vector<size_t>& rows) const;
+
+    std::vector<Node> nodes;
+    std::vector<size_t> node_rows;
+};
+
+#endif /* NAME_TRIE_HPP */
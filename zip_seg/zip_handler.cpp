@@ -2,82 +2,184 @@
 #include "defs.hpp"
 #include <iostream>
 #include <algorithm>
+#include <filesystem>
+#include <atomic>
+#include "parallel.hpp"
+#include "io_planner.hpp"
+#include "sig_scan.hpp"
+#include "hash.hpp"
+#include "crc32.hpp"
+#include "entry_decoder.hpp"
+#include "entry_encoder.hpp"
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <memory>
+#include <iterator>
+#include <cstring>
+#include <cerrno>
+#include <charconv>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <functional>
+
+/* an entry name that stays inside the extraction directory: relative, and without "." or ".." components */
+static bool isSafeEntryPath(std::string_view name) {
+    if (name.empty() || name.front() == '/') {
+        return false;
+    }
+    size_t pos = 0;
+    while (pos < name.size()) {
+        size_t end = std::min(name.find('/', pos), name.size());
+        std::string_view comp = name.substr(pos, end - pos);
+        /* an empty component is only allowed as the trailing '/' of a directory entry */
+        if (comp == "." || comp == ".." || (comp.empty() && end != name.size() - 1)) {
+            return false;
+        }
+        pos = end + 1;
+    }
+    return true;
+}
+
+/* point the local header at its file data, bit 3 entries take their data size from the central directory */
+static bool attachLocalFileData(LocalFileHeader& header, const CentralDirectoryRecord& central, const ZipSource* source) {
+    if (!header.attachDataSource(source)) {
+        return false;
+    }
+    return !header.usesDataDescriptor() || header.applyDataDescriptor(central.getEffectiveCompressedSize());
+}
 
 ZipHandler::ZipHandler(std::ifstream& file, std::string parse_mode) : file(std::move(file)), parse_mode(parse_mode) {}
 
+bool ZipHandler::openSource(const std::string& path, bool use_mmap) {
+    source_path = path;
+    return source.open(path, use_mmap);
+}
+
 bool ZipHandler::parse() {
+    bool success = false;
     if (parse_mode == "standard") {
-        return parseStandard();
+        success = parseStandard();
     } else if (parse_mode == "stream") {
-        uint16_t success_count = parseStream();
+        uint64_t success_count = parseStream();
 
         local_file_header_count = success_count;
 
-        return success_count > 0;
+        success = success_count > 0;
     } else {
         return false;
     }
+
+    if (success) {
+        refreshIndexes();
+    }
+    return success;
+}
+
+void ZipHandler::refreshIndexes() {
+    indexes_built = false;
+    if (!compact_directory) {
+        ensureIndexes();
+    }
+}
+
+void ZipHandler::ensureIndexes() const {
+    if (!indexes_built) {
+        buildIndexes();
+        indexes_built = true;
+    }
+}
+
+void ZipHandler::buildIndexes() const {
+    central_directory_index.build(central_directory_records);
+
+    std::vector<std::string_view> names;
+    std::vector<uint64_t> compressed_sizes;
+    std::vector<uint64_t> uncompressed_sizes;
+    names.reserve(std::max(local_file_headers.size(), central_directory_records.size()));
+    compressed_sizes.reserve(names.capacity());
+    uncompressed_sizes.reserve(names.capacity());
+    for (const auto& header : local_file_headers) {
+        names.push_back(header.getFilename());
+        /* bit 3 entries only know their sizes from the data descriptor */
+        compressed_sizes.push_back(header.getFileData().getSize());
+        uncompressed_sizes.push_back(header.hasDataDescriptor() ? header.getDataDescriptor().getUncompressedSize()
+                                                                : header.getEffectiveUncompressedSize());
+    }
+    local_file_header_names.build(names);
+    local_file_header_tree.build(names, compressed_sizes, uncompressed_sizes);
+
+    names.clear();
+    for (size_t i = 0; i < central_directory_records.size(); ++i) {
+        names.push_back(central_directory_records[i].getFilename());
+    }
+    central_directory_header_names.build(names);
+    central_directory_header_tree.build(names, central_directory_index.getCompressedSizes(),
+                                        central_directory_index.getUncompressedSizes());
 }
 
 bool ZipHandler::parseStandard() {
+    if (source.isMapped()) {
+        return parseStandardMapped();
+    }
+
     if (!file.is_open() || !file.good()) {
         return false;
     }
 
-    /* find EndOfCentralDirectoryRecord from end of file */
-    std::streampos record_pos = EndOfCentralDirectoryRecord::findFromEnd(file);
-    if (record_pos == -1) {
+    std::streampos record_pos;
+    if (!readEndRecords(record_pos)) {
         return false;
     }
 
-    /* move file pointer to record position and read */
-    file.seekg(record_pos);
-    if (!end_of_central_directory_record.readFromFile(file)) {
+    /* slurp the whole central directory with a single read and decode it from memory */
+    uint64_t central_dir_offset = getCentralDirOffset();
+    central_dir_buffer.resize(static_cast<size_t>(centralDirectoryReadSize(record_pos)));
+    if (!source.readAt(central_dir_offset, central_dir_buffer.data(), central_dir_buffer.size())) {
+        return false;
+    }
+    if (!decodeCentralDirectory(central_dir_buffer.data(), central_dir_buffer.size())) {
         return false;
     }
 
-    /* move file pointer to start of central directory */
-    file.seekg(end_of_central_directory_record.getCentralDirOffset());
+    return parseLocalFileHeaders();
+}
 
-    for (uint16_t i = 0; i < end_of_central_directory_record.getCentralDirRecordCount(); ++i) {
-        CentralDirectoryHeader header;
-        if (!header.readFromFile(file)) {
-            return false;
-        }
-        central_directory_headers.push_back(std::move(header));
+uint64_t ZipHandler::parseStream() {
+    if (resolveJobCount(jobs) > 1 && source.isOpen()) {
+        return parseStreamParallel();
     }
-
-    for (const auto& header : central_directory_headers) {
-        file.seekg(header.getLocalFileHeaderOffset());
-        LocalFileHeader local_header;
-        if (!local_header.readFromFile(file)) {
-            return false;
-        }
-        local_file_headers.push_back(std::move(local_header));
+    if (source.isMapped()) {
+        return parseStreamMapped();
     }
 
-    return true;
-}
-
-uint16_t ZipHandler::parseStream() {
     if (!file.is_open() || !file.good()) {
         return 0;
     }
     /* start from the first byte of the file */
     file.seekg(0);
 
-    uint16_t success_count = 0;
+    uint64_t success_count = 0;
     /* parse only local file headers */
     while (true) {
         /* create a local file header object */
         LocalFileHeader local_header;
 
         /* try to read local file header */
-        if (!local_header.readFromFile(file)) {
+        if (!local_header.readFromFile(file, &metadata_arena) || !local_header.attachDataSource(&source)) {
             /* parse failed, return false */
             return success_count;
         }
 
+        /* bit 3 entries may not know their size, continue after the data descriptor */
+        if (local_header.usesDataDescriptor()) {
+            if (!resolveDataDescriptor(local_header)) {
+                return success_count;
+            }
+            file.seekg(static_cast<std::streamoff>(local_header.getRecordEnd()));
+        }
+
         /* read success, increment success count */
         success_count++;
 
@@ -88,6 +190,500 @@ uint16_t ZipHandler::parseStream() {
     return success_count;
 }
 
+bool ZipHandler::readEndRecords(std::streampos& record_pos) {
+    /* find EndOfCentralDirectoryRecord from end of file */
+    record_pos = EndOfCentralDirectoryRecord::findFromEnd(source);
+    if (record_pos == -1) {
+        return false;
+    }
+
+    if (source.isMapped()) {
+        BufferReader reader(source.getData(), source.getSize(), static_cast<size_t>(record_pos));
+        if (!end_of_central_directory_record.readFromBuffer(reader)) {
+            return false;
+        }
+    } else {
+        /* move file pointer to record position and read */
+        file.seekg(record_pos);
+        if (!end_of_central_directory_record.readFromFile(file)) {
+            return false;
+        }
+    }
+
+    /* a ZIP64 locator sits right before the EOCD */
+    uint64_t eocd_offset = static_cast<uint64_t>(record_pos);
+    if (eocd_offset < Zip64EndOfCentralDirectoryLocator::RECORD_SIZE) {
+        return true;
+    }
+    uint8_t locator_bytes[Zip64EndOfCentralDirectoryLocator::RECORD_SIZE];
+    if (!source.readAt(eocd_offset - sizeof(locator_bytes), locator_bytes, sizeof(locator_bytes))) {
+        return true;
+    }
+    BufferReader locator_reader(locator_bytes, sizeof(locator_bytes));
+    if (!zip64_end_of_central_directory_locator.readFromBuffer(locator_reader)) {
+        return true;
+    }
+
+    /* the locator is authoritative, a broken ZIP64 record makes the archive unreadable */
+    uint64_t record_offset = zip64_end_of_central_directory_locator.getZip64EocdOffset();
+    uint64_t available = record_offset < source.getSize() ? source.getSize() - record_offset : 0;
+    if (available < Zip64EndOfCentralDirectoryRecord::MIN_RECORD_SIZE) {
+        return false;
+    }
+    uint8_t fixed[Zip64EndOfCentralDirectoryRecord::MIN_RECORD_SIZE];
+    if (!source.readAt(record_offset, fixed, sizeof(fixed))) {
+        return false;
+    }
+    BufferReader fixed_reader(fixed, sizeof(fixed));
+    Zip64EndOfCentralDirectoryRecord probe;
+    if (!probe.readFromBuffer(fixed_reader)) {
+        return false;
+    }
+
+    /* read the record again together with its extensible data sector */
+    uint64_t record_size = probe.getSizeOfRecord() + 12;
+    if (record_size > available) {
+        return false;
+    }
+    std::vector<uint8_t> record_bytes(static_cast<size_t>(record_size));
+    if (!source.readAt(record_offset, record_bytes.data(), record_bytes.size())) {
+        return false;
+    }
+    BufferReader record_reader(record_bytes.data(), record_bytes.size());
+    if (!zip64_end_of_central_directory_record.readFromBuffer(record_reader)) {
+        return false;
+    }
+
+    has_zip64_records = true;
+    return true;
+}
+
+bool ZipHandler::parseLocalFileHeadersParallel() {
+    std::vector<LocalFileHeader> headers(central_directory_records.size());
+    std::atomic<bool> failed(false);
+
+    parallelForRanges(headers.size(), resolveJobCount(jobs), [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end && !failed.load(std::memory_order_relaxed); ++i) {
+            /* decode in place, views point into the mapping */
+            uint64_t offset = central_directory_records[i].getLocalFileHeaderOffset();
+            BufferReader reader(source.getData(), source.getSize());
+            bool ok = offset <= source.getSize() && reader.seek(static_cast<size_t>(offset)) &&
+                      headers[i].readFromBuffer(reader);
+            if (!ok || !attachLocalFileData(headers[i], central_directory_records[i], &source)) {
+                failed.store(true, std::memory_order_relaxed);
+            }
+        }
+    });
+
+    if (failed.load()) {
+        return false;
+    }
+    local_file_headers = std::move(headers);
+    return true;
+}
+
+bool ZipHandler::parseLocalFileHeadersPlanned() {
+    /* reading up to this many unrelated bytes is cheaper than a seek on disks and network filesystems */
+    const uint64_t max_gap = 64 * 1024;
+    const uint64_t max_batch_size = 8 * 1024 * 1024;
+    /* local extra fields are often a little longer than the central ones */
+    const uint64_t extra_slack = 64;
+
+    IoPlanner planner(max_gap, max_batch_size);
+    planner.reserve(central_directory_records.size());
+    for (size_t i = 0; i < central_directory_records.size(); ++i) {
+        CentralDirectoryRecord header = central_directory_records[i];
+        uint64_t expected = LocalFileHeader::FIXED_SIZE + header.getFilenameLength() +
+                            header.getExtraFieldLength() + extra_slack;
+        planner.addRequest(header.getLocalFileHeaderOffset(), expected, i);
+    }
+    planner.plan(source.getSize());
+
+    const auto& requests = planner.getRequests();
+    const auto& batches = planner.getBatches();
+    /* a header starting past the end of the file can never be read */
+    if (!requests.empty() && (batches.empty() || batches.back().last != requests.size())) {
+        return false;
+    }
+
+    std::vector<LocalFileHeader> headers(central_directory_records.size());
+    std::atomic<bool> failed(false);
+
+    parallelForRanges(batches.size(), resolveJobCount(jobs), [&](size_t, size_t begin, size_t end) {
+        std::vector<uint8_t> buffer;
+        for (size_t b = begin; b < end && !failed.load(std::memory_order_relaxed); ++b) {
+            const ReadBatch& batch = batches[b];
+            buffer.resize(static_cast<size_t>(batch.length));
+            if (!source.readAt(batch.offset, buffer.data(), buffer.size())) {
+                failed.store(true, std::memory_order_relaxed);
+                return;
+            }
+
+            for (size_t r = batch.first; r < batch.last; ++r) {
+                const ReadRequest& request = requests[r];
+                LocalFileHeader& header = headers[request.index];
+                size_t relative = static_cast<size_t>(request.offset - batch.offset);
+                /* headers larger than estimated are read on their own */
+                bool ok = header.readFromBufferCopy(buffer.data() + relative, buffer.size() - relative, request.offset,
+                                                     &metadata_arena) ||
+                          header.readFromSource(source, request.offset, &metadata_arena);
+                if (!ok || !attachLocalFileData(header, central_directory_records[request.index], &source)) {
+                    failed.store(true, std::memory_order_relaxed);
+                    return;
+                }
+            }
+        }
+    });
+
+    if (failed.load()) {
+        return false;
+    }
+    local_file_headers = std::move(headers);
+    return true;
+}
+
+uint64_t ZipHandler::parseStreamParallel() {
+    /* small enough to balance the workers, large enough to keep each search in long sequential runs */
+    const uint64_t min_chunk_size = 4 * 1024 * 1024;
+    const size_t read_size = 1024 * 1024;
+
+    /* only the extent of a candidate is kept, most of them never make it into the chain */
+    struct Candidate {
+        uint64_t offset;
+        uint64_t record_end;
+        /* size of the file data found for bit 3 entries */
+        uint64_t data_size;
+        /* true if the data (and descriptor) ends exactly where another record or the file begins */
+        bool linked;
+    };
+
+    const uint64_t file_size = source.getSize();
+    unsigned workers = resolveJobCount(jobs);
+    uint64_t chunk_size = std::max<uint64_t>(min_chunk_size, file_size / (workers * 4) + 1);
+    size_t chunk_count = static_cast<size_t>((file_size + chunk_size - 1) / chunk_size);
+    std::vector<std::vector<Candidate>> chunks(chunk_count);
+
+    /* a view into the mapping, otherwise a copy in arena, or owned by the header without one */
+    auto decode = [&](uint64_t offset, LocalFileHeader& header, MetadataArena* arena) {
+        if (source.isMapped()) {
+            BufferReader reader(source.getData(), static_cast<size_t>(file_size), static_cast<size_t>(offset));
+            return header.readFromBuffer(reader) && header.attachDataSource(&source);
+        }
+        return header.readFromSource(source, offset, arena) && header.attachDataSource(&source);
+    };
+
+    /* decode a candidate in scratch storage and check where its extent lands */
+    auto examine = [&](uint64_t offset, std::vector<Candidate>& found) {
+        LocalFileHeader header;
+        if (!decode(offset, header, nullptr)) {
+            return;
+        }
+        uint64_t data_size = 0;
+        if (header.usesDataDescriptor()) {
+            data_size = header.getEffectiveCompressedSize();
+            if (data_size == 0 &&
+                !DataDescriptor::locate(source, header.getFileData().getOffset(), header.isZip64(), data_size)) {
+                return;
+            }
+            if (!header.applyDataDescriptor(data_size)) {
+                return;
+            }
+        }
+
+        Candidate candidate{offset, header.getRecordEnd(), data_size, false};
+        uint64_t end = candidate.record_end;
+        uint8_t next[4];
+        if (end == file_size) {
+            candidate.linked = true;
+        } else if (end + sizeof(next) <= file_size && source.readAt(end, next, sizeof(next))) {
+            uint32_t signature = loadLittleEndian<uint32_t>(next);
+            candidate.linked = signature == LOCAL_FILE_HEADER_SIG || signature == CENTRAL_DIRECTORY_HEADER_SIG ||
+                               signature == END_OF_CENTRAL_DIRECTORY_SIG ||
+                               signature == ZIP64_END_OF_CENTRAL_DIRECTORY_SIG;
+        }
+        found.push_back(candidate);
+    };
+
+    parallelForRanges(chunk_count, workers, [&](size_t, size_t begin, size_t end) {
+        std::vector<uint8_t> buffer;
+        for (size_t c = begin; c < end; ++c) {
+            uint64_t chunk_begin = c * chunk_size;
+            uint64_t chunk_end = std::min(file_size, chunk_begin + chunk_size);
+            std::vector<Candidate>& found = chunks[c];
+
+            if (source.isMapped()) {
+                /* signatures may start anywhere in the chunk and end up to three bytes past it */
+                size_t limit = static_cast<size_t>(std::min(file_size, chunk_end + 3));
+                size_t pos = static_cast<size_t>(chunk_begin);
+                while ((pos = findSignatureForward(source.getData(), limit, LOCAL_FILE_HEADER_SIG, pos)) != SIG_NOT_FOUND) {
+                    examine(pos, found);
+                    ++pos;
+                }
+                continue;
+            }
+
+            buffer.resize(read_size + 3);
+            for (uint64_t piece = chunk_begin; piece < chunk_end; piece += read_size) {
+                size_t length = static_cast<size_t>(std::min<uint64_t>(read_size + 3, file_size - piece));
+                if (!source.readAt(piece, buffer.data(), length)) {
+                    break;
+                }
+                /* only starts inside this piece count, the overlap belongs to the next one */
+                size_t starts = static_cast<size_t>(std::min<uint64_t>(read_size, chunk_end - piece));
+                size_t pos = 0;
+                while ((pos = findSignatureForward(buffer.data(), length, LOCAL_FILE_HEADER_SIG, pos)) != SIG_NOT_FOUND &&
+                       pos < starts) {
+                    examine(piece + pos, found);
+                    ++pos;
+                }
+            }
+        }
+    });
+
+    /* chunks are in file order and so are their candidates, follow the chain from the first byte */
+    std::vector<Candidate> candidates;
+    for (auto& found : chunks) {
+        std::move(found.begin(), found.end(), std::back_inserter(candidates));
+        std::vector<Candidate>().swap(found);
+    }
+
+    uint64_t success_count = 0;
+    uint64_t offset = 0;
+    while (true) {
+        auto it = std::lower_bound(candidates.begin(), candidates.end(), offset,
+                                   [](const Candidate& candidate, uint64_t value) { return candidate.offset < value; });
+        if (it == candidates.end() || it->offset != offset) {
+            break;
+        }
+        /* decoded again, this time into the arena, now that it is known to belong to the archive */
+        LocalFileHeader header;
+        if (!decode(it->offset, header, &metadata_arena) ||
+            (header.usesDataDescriptor() && !header.applyDataDescriptor(it->data_size))) {
+            break;
+        }
+        offset = it->record_end;
+        bool linked = it->linked;
+        local_file_headers.push_back(std::move(header));
+        success_count++;
+        /* an entry whose data runs into garbage is the last one, as in the sequential scan */
+        if (!linked) {
+            break;
+        }
+    }
+
+    return success_count;
+}
+
+bool ZipHandler::resolveDataDescriptor(LocalFileHeader& header) const {
+    /* writers that stream their output leave the size at zero and only record it after the data */
+    uint64_t data_size = header.getEffectiveCompressedSize();
+    if (data_size == 0 &&
+        !DataDescriptor::locate(source, header.getFileData().getOffset(), header.isZip64(), data_size)) {
+        std::cerr << "Cannot find the end of the file data of " << header.getFilename() << std::endl;
+        return false;
+    }
+    return header.applyDataDescriptor(data_size);
+}
+
+uint64_t ZipHandler::getCentralDirOffset() const {
+    uint64_t offset = static_cast<uint64_t>(end_of_central_directory_record.getCentralDirOffset());
+    if (has_zip64_records && offset == ZIP64_ESCAPE_32) {
+        return zip64_end_of_central_directory_record.getCentralDirOffset();
+    }
+    return offset;
+}
+
+uint64_t ZipHandler::getCentralDirSize() const {
+    uint64_t size = end_of_central_directory_record.getCentralDirSize();
+    if (has_zip64_records && size == ZIP64_ESCAPE_32) {
+        return zip64_end_of_central_directory_record.getCentralDirSize();
+    }
+    return size;
+}
+
+uint64_t ZipHandler::getCentralDirRecordCount() const {
+    uint64_t count = end_of_central_directory_record.getCentralDirRecordCount();
+    if (has_zip64_records && count == ZIP64_ESCAPE_16) {
+        return zip64_end_of_central_directory_record.getCentralDirRecordCount();
+    }
+    return count;
+}
+
+bool ZipHandler::parseStandardMapped() {
+    std::streampos record_pos;
+    if (!readEndRecords(record_pos)) {
+        return false;
+    }
+
+    /* decode central directory headers in place */
+    uint64_t central_dir_offset = getCentralDirOffset();
+    if (central_dir_offset > source.getSize()) {
+        return false;
+    }
+    if (!decodeCentralDirectory(source.getData() + central_dir_offset,
+                                static_cast<size_t>(source.getSize() - central_dir_offset))) {
+        return false;
+    }
+
+    return parseLocalFileHeaders();
+}
+
+bool ZipHandler::parseLocalFileHeaders() {
+    uint64_t directory_hash = 0;
+    bool use_index = !index_path.empty() && hashDirectory(directory_hash);
+    if (use_index && loadLocalFileHeadersFromIndex(directory_hash)) {
+        return true;
+    }
+
+    bool ok = false;
+    if (!source.isMapped()) {
+        /* local file headers are read in offset order rather than central directory order */
+        ok = parseLocalFileHeadersPlanned();
+    } else if (resolveJobCount(jobs) > 1) {
+        ok = parseLocalFileHeadersParallel();
+    } else {
+        ok = parseLocalFileHeadersMapped();
+    }
+
+    if (ok && use_index) {
+        saveIndex(directory_hash);
+    }
+    return ok;
+}
+
+bool ZipHandler::parseLocalFileHeadersMapped() {
+    BufferReader reader(source.getData(), source.getSize());
+
+    /* decode local file headers in place, file data stays in the mapping */
+    local_file_headers.reserve(central_directory_records.size());
+    for (size_t i = 0; i < central_directory_records.size(); ++i) {
+        CentralDirectoryRecord header = central_directory_records[i];
+        if (!reader.seek(static_cast<size_t>(header.getLocalFileHeaderOffset()))) {
+            return false;
+        }
+        LocalFileHeader local_header;
+        if (!local_header.readFromBuffer(reader) || !attachLocalFileData(local_header, header, &source)) {
+            return false;
+        }
+        local_file_headers.push_back(std::move(local_header));
+    }
+
+    return true;
+}
+
+uint64_t ZipHandler::centralDirectoryReadSize(std::streampos record_pos) const {
+    uint64_t central_dir_offset = getCentralDirOffset();
+    /* with ZIP64 the central directory ends where the ZIP64 record starts */
+    uint64_t eocd_offset = has_zip64_records ? zip64_end_of_central_directory_locator.getZip64EocdOffset()
+                                             : static_cast<uint64_t>(record_pos);
+    if (central_dir_offset >= source.getSize()) {
+        return 0;
+    }
+
+    /* trust the declared size, but also cover everything up to the EOCD in case the size field lies */
+    uint64_t read_size = getCentralDirSize();
+    if (central_dir_offset < eocd_offset) {
+        read_size = std::max(read_size, eocd_offset - central_dir_offset);
+    }
+    return std::min(read_size, source.getSize() - central_dir_offset);
+}
+
+bool ZipHandler::hashDirectory(uint64_t& hash) const {
+    uint64_t central_dir_offset = getCentralDirOffset();
+    uint64_t file_size = source.getSize();
+    if (central_dir_offset > file_size) {
+        return false;
+    }
+
+    /*
+     * the declared directory is hashed first and seeds the hash of everything after it, on both backends,
+     * so an index written with --mmap is valid without it and the other way round
+     */
+    size_t directory_size = static_cast<size_t>(std::min(getCentralDirSize(), file_size - central_dir_offset));
+    uint64_t tail_offset = central_dir_offset + directory_size;
+    size_t tail_size = static_cast<size_t>(file_size - tail_offset);
+    if (source.isMapped()) {
+        const uint8_t* data = source.getData();
+        hash = hash64(data + tail_offset, tail_size, hash64(data + central_dir_offset, directory_size));
+        return true;
+    }
+
+    /* the central directory is already in memory, only the end records still have to be read */
+    if (central_dir_buffer.size() < directory_size) {
+        return false;
+    }
+    std::vector<uint8_t> tail(tail_size);
+    if (!source.readAt(tail_offset, tail.data(), tail.size())) {
+        return false;
+    }
+    hash = hash64(tail.data(), tail.size(), hash64(central_dir_buffer.data(), directory_size));
+    return true;
+}
+
+bool ZipHandler::loadLocalFileHeadersFromIndex(uint64_t directory_hash) {
+    if (!index.open(index_path) || !index.matches(source, directory_hash, central_directory_records.size())) {
+        return false;
+    }
+
+    std::vector<LocalFileHeader> headers(central_directory_records.size());
+    for (size_t i = 0; i < headers.size(); ++i) {
+        if (!index.loadLocalFileHeader(i, &source, headers[i])) {
+            return false;
+        }
+    }
+    local_file_headers = std::move(headers);
+    return true;
+}
+
+void ZipHandler::saveIndex(uint64_t directory_hash) const {
+    if (!ZipIndex::write(index_path, source, directory_hash, local_file_headers)) {
+        std::cerr << "Warning: Failed to write index " << index_path << std::endl;
+    }
+}
+
+bool ZipHandler::decodeCentralDirectory(const uint8_t* data, size_t size) {
+    if (!central_directory_records.build(data, size, getCentralDirOffset(), getCentralDirRecordCount())) {
+        return false;
+    }
+    if (compact_directory) {
+        return true;
+    }
+
+    /* the records are known to be complete, decode each in place */
+    central_directory_headers.reserve(central_directory_records.size());
+    for (size_t i = 0; i < central_directory_records.size(); ++i) {
+        CentralDirectoryHeader header;
+        if (!central_directory_records[i].decode(header)) {
+            return false;
+        }
+        central_directory_headers.push_back(std::move(header));
+    }
+    return true;
+}
+
+uint64_t ZipHandler::parseStreamMapped() {
+    BufferReader reader(source.getData(), source.getSize());
+
+    uint64_t success_count = 0;
+    /* parse only local file headers, back to back from the first byte */
+    while (true) {
+        LocalFileHeader local_header;
+        if (!local_header.readFromBuffer(reader) || !local_header.attachDataSource(&source)) {
+            return success_count;
+        }
+        if (local_header.usesDataDescriptor()) {
+            if (!resolveDataDescriptor(local_header) ||
+                !reader.seek(static_cast<size_t>(local_header.getRecordEnd()))) {
+                return success_count;
+            }
+        }
+        success_count++;
+        local_file_headers.push_back(std::move(local_header));
+    }
+
+    return success_count;
+}
+
 void ZipHandler::print() const {
     printLocalFileHeaders();
     printCentralDirectoryHeaders();
@@ -100,7 +696,7 @@ void ZipHandler::printLocalFileHeaders() const {
     }
 }
 
-void ZipHandler::printLocalFileHeaders(uint16_t index) const {
+void ZipHandler::printLocalFileHeaders(size_t index) const {
     if (index < local_file_headers.size()) {
         local_file_headers[index].print();
     } else {
@@ -109,13 +705,21 @@ void ZipHandler::printLocalFileHeaders(uint16_t index) const {
 }
 
 void ZipHandler::printCentralDirectoryHeaders() const {
+    if (compact_directory) {
+        for (size_t i = 0; i < central_directory_records.size(); ++i) {
+            central_directory_records[i].print();
+        }
+        return;
+    }
     for (const auto& header : central_directory_headers) {
         header.print();
     }
 }
 
-void ZipHandler::printCentralDirectoryHeaders(uint16_t index) const {
-    if (index < central_directory_headers.size()) {
+void ZipHandler::printCentralDirectoryHeaders(size_t index) const {
+    if (compact_directory && index < central_directory_records.size()) {
+        central_directory_records[index].print();
+    } else if (index < central_directory_headers.size()) {
         central_directory_headers[index].print();
     } else {
         std::cerr << "Error: Central directory header index out of range" << std::endl;
@@ -123,6 +727,10 @@ void ZipHandler::printCentralDirectoryHeaders(uint16_t index) const {
 }
 
 void ZipHandler::printEndOfCentralDirectoryRecord() const {
+    if (has_zip64_records) {
+        zip64_end_of_central_directory_record.print();
+        zip64_end_of_central_directory_locator.print();
+    }
     if (end_of_central_directory_record.getSignature() == END_OF_CENTRAL_DIRECTORY_SIG) {
         end_of_central_directory_record.print();
     }
@@ -136,14 +744,656 @@ void ZipHandler::listLocalFileHeaders() const {
     }
 }
 
+void ZipHandler::listLocalFileHeaders(const std::vector<size_t>& rows) const {
+    for (size_t idx : rows) {
+        if (idx < local_file_headers.size()) {
+            std::cout << "LFH[" << idx << "]\t" << local_file_headers[idx].getFilename() << std::endl;
+        }
+    }
+}
+
+void ZipHandler::listCentralDirectoryHeaders(const std::vector<size_t>& rows) const {
+    for (size_t idx : rows) {
+        if (idx < getCentralDirectoryHeaderCount()) {
+            std::cout << "CDH[" << idx << "]\t" << getCentralDirectoryHeaderName(idx) << std::endl;
+        }
+    }
+}
+
+std::vector<size_t> ZipHandler::findLocalFileHeaders(std::string_view name) const {
+    ensureIndexes();
+    return local_file_header_names.find(name);
+}
+
+std::vector<size_t> ZipHandler::findCentralDirectoryHeaders(std::string_view name) const {
+    ensureIndexes();
+    return central_directory_header_names.find(name);
+}
+
+void ZipHandler::printDuplicateNames() const {
+    ensureIndexes();
+    size_t count = 0;
+    for (size_t head : central_directory_header_names.getDuplicateHeads()) {
+        std::cout << "Duplicate CDH name: " << central_directory_header_names.getName(head) << " ("
+                  << central_directory_header_names.countRows(head) << " entries)" << std::endl;
+        ++count;
+    }
+    for (size_t head : local_file_header_names.getDuplicateHeads()) {
+        std::cout << "Duplicate LFH name: " << local_file_header_names.getName(head) << " ("
+                  << local_file_header_names.countRows(head) << " entries)" << std::endl;
+        ++count;
+    }
+    if (count == 0) {
+        std::cout << "No duplicate names" << std::endl;
+    }
+}
+
+bool ZipHandler::verify() const {
+    struct Outcome {
+        EntryDecoder::Status status;
+        uint32_t crc;
+        uint64_t size;
+    };
+    size_t count = local_file_headers.size();
+    std::vector<Outcome> outcomes(count);
+    unsigned workers = resolveJobCount(jobs);
+    /* each worker keeps its inflate state and buffers across entries */
+    std::vector<std::unique_ptr<EntryDecoder>> decoders(workers);
+    for (auto& decoder : decoders) {
+        decoder = std::make_unique<EntryDecoder>();
+    }
+
+    /* huge stored entries are checksummed one after the other, each split across all workers */
+    const uint64_t split_threshold = 64 * 1024 * 1024;
+    std::vector<size_t> rows;
+    rows.reserve(count);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        const LocalFileHeader& header = local_file_headers[i];
+        const DataRegion& data = header.getFileData();
+        if (workers == 1 || header.getCompressionMethod() != 0 || (header.getGeneralBitFlag() & GPBF_ENCRYPTED) ||
+            data.getSize() < split_threshold) {
+            rows.push_back(i);
+            continue;
+        }
+        bool ok = data.computeCrc32(workers, outcomes[i].crc);
+        outcomes[i].status = ok ? EntryDecoder::Status::OK : EntryDecoder::Status::READ_ERROR;
+        outcomes[i].size = ok ? data.getSize() : 0;
+    }
+
+    parallelForEach(rows.size(), workers, [&](size_t worker, size_t r) {
+        const LocalFileHeader& header = local_file_headers[rows[r]];
+        Outcome& outcome = outcomes[rows[r]];
+        outcome.status = decoders[worker]->decode(header.getFileData(), header.getCompressionMethod(),
+                                                  header.getGeneralBitFlag(), nullptr, outcome.crc, outcome.size);
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t failed = 0;
+    size_t skipped = 0;
+    uint64_t compressed_bytes = 0;
+    uint64_t checked_bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const LocalFileHeader& header = local_file_headers[i];
+        const Outcome& outcome = outcomes[i];
+        uint32_t expected_crc = 0;
+        uint64_t expected_size = 0;
+        getExpectedChecksum(i, expected_crc, expected_size);
+        compressed_bytes += header.getFileData().getSize();
+        checked_bytes += outcome.size;
+
+        std::string label = "Entry[" + std::to_string(i) + "] " + std::string(header.getFilename()) + ": ";
+        if (outcome.status == EntryDecoder::Status::ENCRYPTED ||
+            outcome.status == EntryDecoder::Status::UNSUPPORTED_METHOD) {
+            std::cout << label << "skipped (" << EntryDecoder::statusName(outcome.status) << ")" << std::endl;
+            ++skipped;
+        } else if (outcome.status != EntryDecoder::Status::OK) {
+            std::cout << label << EntryDecoder::statusName(outcome.status) << std::endl;
+            ++failed;
+        } else if (outcome.crc != expected_crc) {
+            std::cout << label << "CRC mismatch (expected 0x" << std::hex << expected_crc << ", got 0x"
+                      << outcome.crc << std::dec << ")" << std::endl;
+            ++failed;
+        } else if (outcome.size != expected_size) {
+            std::cout << label << "size mismatch (expected " << expected_size << ", got " << outcome.size << ")"
+                      << std::endl;
+            ++failed;
+        }
+    }
+
+    std::cout << "Verified " << count << " entries: " << count - failed - skipped << " ok, " << failed
+              << " failed, " << skipped << " skipped" << std::endl;
+    std::cout << "Read " << compressed_bytes << " compressed bytes, checked " << checked_bytes << " bytes in "
+              << std::fixed << std::setprecision(3) << seconds << " s ("
+              << (seconds > 0 ? static_cast<double>(checked_bytes) / seconds / 1e9 : 0.0) << " GB/s, "
+              << workers << (workers == 1 ? " thread" : " threads") << ", crc32 " << crc32Implementation() << ")"
+              << std::defaultfloat << std::endl;
+    return failed == 0;
+}
+
+void ZipHandler::getExpectedChecksum(size_t index, uint32_t& crc, uint64_t& size) const {
+    const LocalFileHeader& header = local_file_headers[index];
+    /* the central directory is authoritative; without one the local values, or the descriptor after bit 3 data */
+    crc = header.getCrc32();
+    size = header.getEffectiveUncompressedSize();
+    if (index < central_directory_records.size()) {
+        crc = central_directory_records[index].getCrc32();
+        size = central_directory_records[index].getEffectiveUncompressedSize();
+    } else if (header.hasDataDescriptor()) {
+        crc = header.getDataDescriptor().getCrc32();
+        size = header.getDataDescriptor().getUncompressedSize();
+    }
+}
+
+bool ZipHandler::resolveEntry(const std::string& target, size_t& index) const {
+    /* "#N" is always an index, a bare number only if no entry has it as its name */
+    bool explicit_index = !target.empty() && target[0] == '#';
+    const char* begin = target.data() + (explicit_index ? 1 : 0);
+    const char* end = target.data() + target.size();
+    uint64_t value = 0;
+    auto parsed = std::from_chars(begin, end, value);
+    bool numeric = begin != end && parsed.ec != std::errc::invalid_argument && parsed.ptr == end;
+
+    std::vector<size_t> rows;
+    if (!explicit_index) {
+        rows = findLocalFileHeaders(target);
+    }
+    if (rows.empty() && numeric) {
+        if (parsed.ec == std::errc::result_out_of_range || value >= local_file_headers.size()) {
+            std::cerr << "Error: Entry index " << std::string(begin, end) << " out of range ("
+                      << local_file_headers.size() << " entries)" << std::endl;
+            return false;
+        }
+        index = static_cast<size_t>(value);
+        return true;
+    }
+    if (rows.empty()) {
+        std::cerr << "Error: No entry named " << target << std::endl;
+        return false;
+    }
+    if (rows.size() > 1) {
+        std::cerr << "Warning: " << rows.size() << " entries are named " << target << ", using entry " << rows[0]
+                  << std::endl;
+    }
+    index = rows[0];
+    return true;
+}
+
+bool ZipHandler::extract(const std::string& target, const std::string& dest) const {
+    size_t index = 0;
+    if (!resolveEntry(target, index)) {
+        return false;
+    }
+    const LocalFileHeader& header = local_file_headers[index];
+    std::string name(header.getFilename());
+
+    /* into a directory the entry goes under its base name */
+    std::filesystem::path path(dest);
+    std::error_code error;
+    if (std::filesystem::is_directory(path, error)) {
+        std::string base = name;
+        while (!base.empty() && base.back() == '/') {
+            base.pop_back();
+        }
+        base = base.substr(base.find_last_of('/') + 1);
+        if (base.empty()) {
+            std::cerr << "Error: Entry " << index << " has no name to extract to, give a file path" << std::endl;
+            return false;
+        }
+        path /= base;
+    }
+    if (!name.empty() && name.back() == '/') {
+        std::filesystem::create_directories(path, error);
+        if (error) {
+            std::cerr << "Error: Failed to create directory " << path.string() << ": " << error.message() << std::endl;
+            return false;
+        }
+        std::cout << "Created directory " << path.string() << std::endl;
+        return true;
+    }
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+
+    EntryDecoder decoder;
+    uint64_t size = 0;
+    std::string message;
+    if (!writeEntry(decoder, index, path.string(), size, message)) {
+        std::cerr << "Error: " << message << std::endl;
+        return false;
+    }
+    std::cout << "Extracted " << name << " to " << path.string() << " (" << size << " bytes)" << std::endl;
+    return true;
+}
+
+bool ZipHandler::writeEntry(EntryDecoder& decoder, size_t index, const std::string& path, uint64_t& size,
+                            std::string& message) const {
+    const LocalFileHeader& header = local_file_headers[index];
+    std::string label = "Entry[" + std::to_string(index) + "] " + std::string(header.getFilename()) + ": ";
+    /* O_NOFOLLOW: a symlink planted at the destination must not redirect the write */
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, 0644);
+    if (fd < 0) {
+        message = "Failed to open " + path + " for writing: " + std::strerror(errno);
+        return false;
+    }
+    uint32_t crc = 0;
+    EntryDecoder::Status status = decoder.decodeTo(header.getFileData(), header.getCompressionMethod(),
+                                                   header.getGeneralBitFlag(), fd, crc, size);
+    int close_error = close(fd) == 0 ? 0 : errno;
+
+    uint32_t expected_crc = 0;
+    uint64_t expected_size = 0;
+    getExpectedChecksum(index, expected_crc, expected_size);
+    std::ostringstream error;
+    if (status == EntryDecoder::Status::WRITE_ERROR) {
+        error << "Failed to write " << path << ": " << std::strerror(decoder.getWriteError());
+    } else if (status != EntryDecoder::Status::OK) {
+        error << label << EntryDecoder::statusName(status);
+    } else if (close_error != 0) {
+        error << "Failed to write " << path << ": " << std::strerror(close_error);
+    } else if (crc != expected_crc) {
+        error << label << "CRC mismatch (expected 0x" << std::hex << expected_crc << ", got 0x" << crc << ")";
+    } else if (size != expected_size) {
+        error << label << "size mismatch (expected " << expected_size << ", got " << size << ")";
+    } else {
+        return true;
+    }
+
+    /* never leave a truncated or corrupt file behind that looks like a good one */
+    unlink(path.c_str());
+    message = error.str();
+    return false;
+}
+
+bool ZipHandler::extractAll(const std::string& dir) const {
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    if (error) {
+        std::cerr << "Error: Failed to create directory " << dir << ": " << error.message() << std::endl;
+        return false;
+    }
+
+    /*
+     * files are written under their local header names, which may differ from the central directory,
+     * so the directories come from a tree over those same names; one walk creates them, parents first
+     */
+    size_t count = local_file_headers.size();
+    std::vector<std::string_view> names(count);
+    for (size_t i = 0; i < count; ++i) {
+        names[i] = local_file_headers[i].getFilename();
+    }
+    std::vector<uint64_t> no_sizes(count, 0);
+    NameTrie tree;
+    tree.build(names, no_sizes, no_sizes);
+    size_t directory_count = 0;
+    bool directories_ok = true;
+    std::function<void(const NameTrie::Cursor&, const std::string&)> createBelow =
+        [&](const NameTrie::Cursor& cursor, const std::string& path) {
+            tree.forEachChild(cursor, [&](std::string_view comp, const NameTrie::Cursor& next) {
+                if (!tree.hasChildren(next) || comp.empty() || comp == "." || comp == "..") {
+                    return;
+                }
+                std::string child = path + "/" + std::string(comp);
+                if (mkdir(child.c_str(), 0755) != 0 && errno != EEXIST) {
+                    std::cerr << "Error: Failed to create directory " << child << ": " << std::strerror(errno)
+                              << std::endl;
+                    directories_ok = false;
+                    return;
+                }
+                ++directory_count;
+                createBelow(next, child);
+            });
+        };
+    if (!tree.empty()) {
+        createBelow(tree.getRoot(), dir);
+    }
+
+    /* refuse names that escape the directory, and let the last of several same-named entries win */
+    size_t refused = 0;
+    size_t superseded = 0;
+    std::vector<size_t> order;
+    order.reserve(count);
+    std::vector<uint64_t> expected_sizes(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        std::string_view name = names[i];
+        if (!isSafeEntryPath(name)) {
+            std::cerr << "Warning: Entry[" << i << "] " << name << ": refused, not a plain relative path" << std::endl;
+            ++refused;
+            continue;
+        }
+        if (findLocalFileHeaders(name).back() != i) {
+            ++superseded;
+            continue;
+        }
+        if (name.back() == '/') {
+            /* directory entries are empty, their directory already exists */
+            std::filesystem::create_directories(dir + "/" + std::string(name), error);
+            continue;
+        }
+        uint32_t crc = 0;
+        getExpectedChecksum(i, crc, expected_sizes[i]);
+        order.push_back(i);
+    }
+    /* the largest entries first, so no worker picks up a huge one when the others are about to finish */
+    std::stable_sort(order.begin(), order.end(),
+                     [&expected_sizes](size_t a, size_t b) { return expected_sizes[a] > expected_sizes[b]; });
+
+    unsigned workers = resolveJobCount(jobs);
+    std::vector<std::unique_ptr<EntryDecoder>> decoders(workers);
+    for (auto& decoder : decoders) {
+        decoder = std::make_unique<EntryDecoder>();
+    }
+    /* results are kept per entry and reported afterwards, workers share nothing while writing */
+    std::vector<std::string> messages(count);
+    std::vector<uint64_t> sizes(count, 0);
+    std::vector<char> failed(count, 0);
+    auto start = std::chrono::steady_clock::now();
+    parallelForEachStealing(order, workers, [&](size_t worker, size_t i) {
+        std::string path = dir + "/" + std::string(local_file_headers[i].getFilename());
+        failed[i] = !writeEntry(*decoders[worker], i, path, sizes[i], messages[i]);
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t failed_count = 0;
+    uint64_t written_bytes = 0;
+    for (size_t i : order) {
+        if (failed[i]) {
+            std::cerr << "Error: " << messages[i] << std::endl;
+            ++failed_count;
+        } else {
+            written_bytes += sizes[i];
+        }
+    }
+    std::cout << "Extracted " << order.size() - failed_count << " of " << order.size() << " files into " << dir
+              << " (" << directory_count << " directories, " << refused << " refused, " << superseded
+              << " superseded by a later entry of the same name)" << std::endl;
+    std::cout << "Wrote " << written_bytes << " bytes in " << std::fixed << std::setprecision(3) << seconds << " s ("
+              << (seconds > 0 ? static_cast<double>(written_bytes) / seconds / 1e9 : 0.0) << " GB/s, " << workers
+              << (workers == 1 ? " thread" : " threads") << ")" << std::defaultfloat << std::endl;
+    return directories_ok && failed_count == 0;
+}
+
+bool ZipHandler::cat(const std::string& target, int fd) const {
+    size_t index = 0;
+    if (!resolveEntry(target, index)) {
+        return false;
+    }
+    const LocalFileHeader& header = local_file_headers[index];
+    std::string label = "Entry[" + std::to_string(index) + "] " + std::string(header.getFilename()) + ": ";
+
+    /* whatever is still buffered has to come out before the entry */
+    std::cout.flush();
+    EntryDecoder decoder;
+    uint32_t crc = 0;
+    uint64_t size = 0;
+    EntryDecoder::Status status = decoder.decodeTo(header.getFileData(), header.getCompressionMethod(),
+                                                   header.getGeneralBitFlag(), fd, crc, size);
+    if (status == EntryDecoder::Status::WRITE_ERROR) {
+        /* e.g. `| head` has seen enough, stop quietly */
+        if (decoder.getWriteError() == EPIPE) {
+            return true;
+        }
+        std::cerr << "Error: Failed to write " << label << std::strerror(decoder.getWriteError()) << std::endl;
+        return false;
+    }
+    if (status != EntryDecoder::Status::OK) {
+        std::cerr << "Error: " << label << EntryDecoder::statusName(status) << std::endl;
+        return false;
+    }
+
+    /* the data is already out, a bad checksum can only be reported afterwards */
+    uint32_t expected_crc = 0;
+    uint64_t expected_size = 0;
+    getExpectedChecksum(index, expected_crc, expected_size);
+    if (crc != expected_crc) {
+        std::cerr << "Error: " << label << "CRC mismatch (expected 0x" << std::hex << expected_crc << ", got 0x" << crc
+                  << std::dec << ")" << std::endl;
+        return false;
+    }
+    if (size != expected_size) {
+        std::cerr << "Error: " << label << "size mismatch (expected " << expected_size << ", got " << size << ")"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ZipHandler::openStaging() {
+    if (staging.isOpen()) {
+        return true;
+    }
+    /* next to the archive, so saving copies within one filesystem; the temp directory if that is read-only */
+    std::vector<std::string> patterns;
+    if (!source_path.empty()) {
+        patterns.push_back(source_path + ".staging.XXXXXX");
+    }
+    std::error_code error;
+    patterns.push_back((std::filesystem::temp_directory_path(error) / "zip_editor.staging.XXXXXX").string());
+    for (const std::string& pattern : patterns) {
+        std::vector<char> name(pattern.begin(), pattern.end());
+        name.push_back('\0');
+        int fd = mkostemp(name.data(), O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        /* gone from the directory at once, it disappears with the process */
+        unlink(name.data());
+        staging_size = 0;
+        return staging.adopt(fd);
+    }
+    std::cerr << "Error: Failed to create a scratch file for new entries: " << std::strerror(errno) << std::endl;
+    return false;
+}
+
+bool ZipHandler::addEntries(const std::vector<std::string>& paths) {
+    if (parse_mode != "standard") {
+        std::cerr << "Error: Entries can only be added in standard mode" << std::endl;
+        return false;
+    }
+    if (!openStaging()) {
+        return false;
+    }
+    if (added_entry_count == 0) {
+        append_start = 0;
+        for (const auto& header : local_file_headers) {
+            append_start = std::max(append_start, header.getRecordEnd());
+        }
+        append_offset = append_start;
+    }
+
+    /* expand directories first, so that name clashes are found before anything is written */
+    std::vector<std::pair<std::string, std::string>> inputs;
+    bool ok = true;
+    for (const std::string& path : paths) {
+        std::error_code error;
+        std::filesystem::file_status status = std::filesystem::status(path, error);
+        std::string name = std::filesystem::path(path).lexically_normal().relative_path().generic_string();
+        while (!name.empty() && name.back() == '/') {
+            name.pop_back();
+        }
+        if (error || !std::filesystem::exists(status)) {
+            std::cerr << "Error: " << path << ": no such file or directory" << std::endl;
+            ok = false;
+            continue;
+        }
+        if (!isSafeEntryPath(name)) {
+            std::cerr << "Error: " << path << ": cannot be stored as a relative name without \"..\"" << std::endl;
+            ok = false;
+            continue;
+        }
+        if (std::filesystem::is_regular_file(status)) {
+            inputs.emplace_back(path, name);
+            continue;
+        }
+        if (!std::filesystem::is_directory(status)) {
+            std::cerr << "Error: " << path << ": not a regular file or directory" << std::endl;
+            ok = false;
+            continue;
+        }
+
+        std::vector<std::pair<std::string, std::string>> children;
+        for (auto it = std::filesystem::recursive_directory_iterator(path, error);
+             !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+            std::string relative = it->path().lexically_relative(path).generic_string();
+            if (it->is_directory(error)) {
+                children.emplace_back(it->path().string(), name + "/" + relative + "/");
+            } else if (it->is_regular_file(error)) {
+                children.emplace_back(it->path().string(), name + "/" + relative);
+            }
+        }
+        if (error) {
+            std::cerr << "Error: " << path << ": " << error.message() << std::endl;
+            ok = false;
+            continue;
+        }
+        /* directory order is arbitrary, sorted names keep archives reproducible */
+        std::sort(children.begin(), children.end(),
+                  [](const auto& a, const auto& b) { return a.second < b.second; });
+        inputs.emplace_back(path, name + "/");
+        inputs.insert(inputs.end(), children.begin(), children.end());
+    }
+
+    EntryEncoder encoder;
+    std::vector<std::string> added_names;
+    size_t added = 0;
+    uint64_t staged_before = staging_size;
+    for (const auto& input : inputs) {
+        const std::string& name = input.second;
+        if (!findLocalFileHeaders(name).empty() ||
+            std::find(added_names.begin(), added_names.end(), name) != added_names.end()) {
+            std::cerr << "Error: " << name << ": already in the archive" << std::endl;
+            ok = false;
+            continue;
+        }
+        if (!addEntry(input.first, name, encoder)) {
+            ok = false;
+            continue;
+        }
+        added_names.push_back(name);
+        ++added;
+    }
+
+    if (added > 0) {
+        staging.refresh();
+        local_file_header_count = local_file_headers.size();
+        updateEndRecords();
+        refreshIndexes();
+    }
+    std::cout << "Added " << added << (added == 1 ? " entry" : " entries") << " (" << staging_size - staged_before
+              << " bytes of file data)" << std::endl;
+    return ok;
+}
+
+bool ZipHandler::addEntry(const std::string& path, const std::string& name, EntryEncoder& encoder) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        std::cerr << "Error: " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (name.size() > 0xFFFF) {
+        std::cerr << "Error: " << path << ": name too long for a ZIP entry" << std::endl;
+        return false;
+    }
+
+    NewEntry entry;
+    entry.name = name;
+    entry.local_header_offset = append_offset;
+    /* names that are not plain ASCII are stored as UTF-8 */
+    if (std::any_of(name.begin(), name.end(), [](char c) { return static_cast<unsigned char>(c) >= 0x80; })) {
+        entry.general_bit_flag |= GPBF_UTF8;
+    }
+    /* MS-DOS time and date, local time with two second resolution, 1980 at the earliest */
+    struct tm local;
+    localtime_r(&st.st_mtime, &local);
+    if (local.tm_year < 80) {
+        local = tm{};
+        local.tm_year = 80;
+        local.tm_mday = 1;
+    }
+    entry.last_mod_time = static_cast<uint16_t>((local.tm_hour << 11) | (local.tm_min << 5) | (local.tm_sec / 2));
+    entry.last_mod_date =
+        static_cast<uint16_t>(((local.tm_year - 80) << 9) | ((local.tm_mon + 1) << 5) | local.tm_mday);
+    entry.external_attr = (static_cast<uint32_t>(st.st_mode) & 0xFFFF) << 16;
+
+    if (S_ISDIR(st.st_mode)) {
+        /* MS-DOS directory attribute */
+        entry.external_attr |= 0x10;
+    } else {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            std::cerr << "Error: " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        EntryEncoder::Result result;
+        bool encoded = encoder.encode(fd, static_cast<uint64_t>(st.st_size), staging.getFd(), staging_size,
+                                      resolveJobCount(jobs), result);
+        close(fd);
+        if (!encoded) {
+            std::cerr << "Error: Failed to compress " << path << std::endl;
+            return false;
+        }
+        entry.compression_method = result.compression_method;
+        entry.crc32 = result.crc32;
+        entry.compressed_size = result.compressed_size;
+        entry.uncompressed_size = result.uncompressed_size;
+    }
+
+    std::vector<uint8_t> bytes;
+    encodeLocalFileHeader(entry, bytes);
+    LocalFileHeader header;
+    if (!header.readFromBufferCopy(bytes.data(), bytes.size(), append_offset, &metadata_arena)) {
+        return false;
+    }
+    header.setFileData(DataRegion(&staging, staging_size, entry.compressed_size));
+    local_file_headers.push_back(std::move(header));
+    staging_size += entry.compressed_size;
+    append_offset += bytes.size() + entry.compressed_size;
+
+    /* the record lives in the arena, so decoded headers and the compact directory can both view it */
+    encodeCentralDirectoryHeader(entry, bytes);
+    uint8_t* record = metadata_arena.allocate(bytes.size());
+    std::memcpy(record, bytes.data(), bytes.size());
+    central_directory_records.append(record);
+    if (!compact_directory) {
+        CentralDirectoryHeader central;
+        central_directory_records[central_directory_records.size() - 1].decode(central);
+        central_directory_headers.push_back(std::move(central));
+    }
+    added_entries.push_back(std::move(entry));
+    ++added_entry_count;
+    return true;
+}
+
+void ZipHandler::updateEndRecords() {
+    uint64_t count = central_directory_records.size();
+    uint64_t size = 0;
+    for (size_t i = 0; i < central_directory_records.size(); ++i) {
+        size += central_directory_records[i].getSize();
+    }
+    /* the central directory follows the last entry */
+    bool escaped = end_of_central_directory_record.update(count, size, append_offset);
+    if (escaped || has_zip64_records) {
+        zip64_end_of_central_directory_record.update(count, size, append_offset);
+        zip64_end_of_central_directory_locator.update(append_offset + size);
+        has_zip64_records = true;
+    }
+}
+
 void ZipHandler::listCentralDirectoryHeaders() const {
-    size_t idx = 0;
-    for (const auto& header : central_directory_headers) {
-        std::cout << "CDH[" << idx << "]\t" << header.getFilename() << std::endl;
-        ++idx;
+    for (size_t idx = 0; idx < getCentralDirectoryHeaderCount(); ++idx) {
+        std::cout << "CDH[" << idx << "]\t" << getCentralDirectoryHeaderName(idx) << std::endl;
     }
 }
 
+size_t ZipHandler::getCentralDirectoryHeaderCount() const {
+    return compact_directory ? central_directory_records.size() : central_directory_headers.size();
+}
+
+std::string_view ZipHandler::getCentralDirectoryHeaderName(size_t index) const {
+    return compact_directory ? central_directory_records[index].getFilename()
+                             : central_directory_headers[index].getFilename();
+}
+
 
 /**
  * saves the ZIP file to the specified output path
@@ -151,6 +1401,10 @@ void ZipHandler::listCentralDirectoryHeaders() const {
  * @return True if save was successful, false otherwise
  */
 bool ZipHandler::save(const std::string& output_path) {
+    if (canSaveInPlace(output_path)) {
+        return saveInPlace(output_path);
+    }
+
     try {
         /* create directory structure if it doesn't exist */
         size_t last_slash_pos = output_path.find_last_of("/\\");
@@ -164,10 +1418,15 @@ bool ZipHandler::save(const std::string& output_path) {
             }
         }
 
+        /* the archive is still read while it is written, so it is only replaced once the copy is complete */
+        std::error_code error;
+        bool replaces_source = !source_path.empty() && std::filesystem::equivalent(output_path, source_path, error);
+        std::string write_path = replaces_source ? output_path + ".saving" : output_path;
+
         /* open output file in binary mode using the object's output_file member */
-        output_file.open(output_path, std::ios::binary);
+        output_file.open(write_path, std::ios::binary);
         if (!output_file.is_open()) {
-            std::cerr << "Error: Could not open output file: " << output_path << std::endl;
+            std::cerr << "Error: Could not open output file: " << write_path << std::endl;
             return false;
         }
 
@@ -175,6 +1434,14 @@ bool ZipHandler::save(const std::string& output_path) {
 
         /* close the file after writing */
         output_file.close();
+        if (output_file.fail()) {
+            std::cerr << "Error: Failed to write output file: " << write_path << std::endl;
+            return false;
+        }
+        if (replaces_source) {
+            /* the open source keeps reading the old file, which goes away when it is closed */
+            std::filesystem::rename(write_path, output_path);
+        }
 
         std::cout << "ZIP file successfully saved to: " << output_path << std::endl;
         return true;
@@ -188,12 +1455,174 @@ bool ZipHandler::save(const std::string& output_path) {
     }
 }
 
+bool ZipHandler::canSaveInPlace(const std::string& output_path) const {
+    if (added_entry_count == 0 || source_path.empty() || parse_mode != "standard") {
+        return false;
+    }
+    std::error_code error;
+    if (!std::filesystem::equivalent(output_path, source_path, error)) {
+        return false;
+    }
+
+    /* the very file that was parsed, not a replacement and not changed by someone else since */
+    struct stat parsed;
+    struct stat current;
+    if (fstat(source.getFd(), &parsed) != 0 || stat(source_path.c_str(), &current) != 0) {
+        return false;
+    }
+    int64_t modification_time = static_cast<int64_t>(current.st_mtim.tv_sec) * 1000000000 + current.st_mtim.tv_nsec;
+    return parsed.st_dev == current.st_dev && parsed.st_ino == current.st_ino &&
+           static_cast<uint64_t>(current.st_size) == source.getSize() &&
+           modification_time == source.getModificationTime() && append_start <= source.getSize();
+}
+
+bool ZipHandler::saveInPlace(const std::string& output_path) {
+    /*
+     * nothing that is already in the file is touched: the added entries, the new central directory and
+     * the end records all go after its end, the old directory stays behind as unused bytes. until the
+     * new end record is on disk the old one still describes the old archive, and the views into the
+     * mapping and the directory buffer stay valid while the new directory is written
+     */
+    uint64_t file_size = source.getSize();
+    /* the added entries were laid out for a rewrite, where they follow the last entry */
+    uint64_t shift = file_size - append_start;
+    size_t first_added = local_file_headers.size() - added_entry_count;
+    size_t first_added_record = central_directory_records.size() - added_entry_count;
+
+    output_file.open(output_path, std::ios::binary | std::ios::in | std::ios::out);
+    if (!output_file.is_open()) {
+        std::cerr << "Error: Could not open output file: " << output_path << std::endl;
+        return false;
+    }
+    output_file.seekp(static_cast<std::streamoff>(file_size));
+    for (size_t i = first_added; i < local_file_headers.size(); ++i) {
+        local_file_headers[i].writeToFile(output_file);
+    }
+
+    uint64_t directory_offset = append_offset + shift;
+    uint64_t directory_size = 0;
+    for (size_t i = 0; i < first_added_record; ++i) {
+        if (compact_directory) {
+            central_directory_records[i].writeToFile(output_file);
+        } else {
+            central_directory_headers[i].writeToFile(output_file);
+        }
+        directory_size += central_directory_records[i].getSize();
+    }
+    std::vector<uint8_t> bytes;
+    for (const NewEntry& added : added_entries) {
+        NewEntry entry = added;
+        entry.local_header_offset += shift;
+        encodeCentralDirectoryHeader(entry, bytes);
+        output_file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        directory_size += bytes.size();
+    }
+
+    /* the entries and the directory have to be on disk before an end record points at them */
+    output_file.flush();
+    int fd = open(output_path.c_str(), O_WRONLY | O_CLOEXEC);
+    bool ok = !output_file.fail() && fd >= 0 && fsync(fd) == 0;
+
+    EndOfCentralDirectoryRecord end_record = end_of_central_directory_record;
+    Zip64EndOfCentralDirectoryRecord zip64_end_record = zip64_end_of_central_directory_record;
+    Zip64EndOfCentralDirectoryLocator zip64_locator = zip64_end_of_central_directory_locator;
+    uint64_t count = central_directory_records.size();
+    if (ok) {
+        if (end_record.update(count, directory_size, directory_offset) || has_zip64_records) {
+            zip64_end_record.update(count, directory_size, directory_offset);
+            zip64_locator.update(directory_offset + directory_size);
+            zip64_end_record.writeToFile(output_file);
+            zip64_locator.writeToFile(output_file);
+        }
+        end_record.writeToFile(output_file);
+        output_file.flush();
+        ok = !output_file.fail() && fsync(fd) == 0;
+    }
+    int error = errno;
+    uint64_t written = ok ? static_cast<uint64_t>(output_file.tellp()) - file_size : 0;
+    output_file.close();
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (!ok) {
+        std::cerr << "Error: Failed to append to " << output_path << ": " << std::strerror(error) << std::endl;
+        return false;
+    }
+
+    std::cout << "Appended " << added_entry_count << (added_entry_count == 1 ? " entry" : " entries")
+              << " and a new central directory to " << output_path << " (" << written << " bytes written, "
+              << file_size - append_start << " bytes of the old directory left unused)" << std::endl;
+
+    /* the old directory no longer describes the archive, parse it again rather than patch every view */
+    if (!reload()) {
+        std::cerr << "Error: Failed to parse " << output_path << " again after saving" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ZipHandler::reload() {
+    bool mapped = source.isMapped();
+
+    /* headers view into the arena, the directory buffer and the mapping, so they go first */
+    local_file_headers.clear();
+    central_directory_headers.clear();
+    central_directory_records.clear();
+    std::vector<uint8_t>().swap(central_dir_buffer);
+    metadata_arena.release();
+    staging.close();
+    staging_size = 0;
+    append_start = 0;
+    append_offset = 0;
+    added_entry_count = 0;
+    added_entries.clear();
+    has_zip64_records = false;
+
+    if (!source.open(source_path, mapped)) {
+        return false;
+    }
+    file.clear();
+    file.seekg(0);
+    return parse();
+}
+
 void ZipHandler::writeToFile() {
-    for (const auto& header : local_file_headers) {
-        header.writeToFile(output_file);
+    /*
+     * in standard mode header i was read where record i points, keep it there so the copied records stay
+     * right; bytes between entries, such as a directory left behind by an append, are copied along
+     */
+    bool keep_offsets =
+        parse_mode == "standard" && local_file_headers.size() == central_directory_records.size();
+    std::vector<uint8_t> gap;
+    for (size_t i = 0; i < local_file_headers.size(); ++i) {
+        if (keep_offsets) {
+            uint64_t pos = static_cast<uint64_t>(output_file.tellp());
+            uint64_t offset = central_directory_records[i].getLocalFileHeaderOffset();
+            if (offset > pos && offset <= source.getSize()) {
+                gap.resize(static_cast<size_t>(offset - pos));
+                if (!source.readAt(pos, gap.data(), gap.size())) {
+                    std::fill(gap.begin(), gap.end(), 0);
+                }
+                output_file.write(reinterpret_cast<const char*>(gap.data()), static_cast<std::streamsize>(gap.size()));
+            }
+        }
+        local_file_headers[i].writeToFile(output_file);
+    }
+    writeCentralDirectory();
+}
+
+void ZipHandler::writeCentralDirectory() {
+    if (compact_directory) {
+        for (size_t i = 0; i < central_directory_records.size(); ++i) {
+            central_directory_records[i].writeToFile(output_file);
+        }
     }
     for (const auto& header : central_directory_headers) {
         header.writeToFile(output_file);
     }
+    if (has_zip64_records) {
+        zip64_end_of_central_directory_record.writeToFile(output_file);
+        zip64_end_of_central_directory_locator.writeToFile(output_file);
+    }
     end_of_central_directory_record.writeToFile(output_file);
 }
@@ -4,42 +4,301 @@
 #include <fstream>
 #include <string>
 #include "zip_seg.hpp"
+#include "zip_source.hpp"
+#include "zip_index.hpp"
+#include "cd_index.hpp"
+#include "cd_record.hpp"
+#include "name_index.hpp"
+#include "name_trie.hpp"
+#include "entry_encoder.hpp"
+
+class EntryDecoder;
 
 class ZipHandler {
 public:
     ZipHandler(std::ifstream& file, std::string parse_mode);
     ~ZipHandler() = default;
+
+    /**
+     * open a read-only handle on the archive next to the stream, file data is read through it on demand
+     * @param path path of the archive
+     * @param use_mmap map the archive once and keep views into the mapping instead of copies
+     * @return true if the archive was opened (and mapped if requested)
+     */
+    bool openSource(const std::string& path, bool use_mmap);
+
+    /* number of worker threads used for parsing, 0 means one per hardware thread */
+    void setJobs(unsigned jobs) { this->jobs = jobs; }
+
+    /**
+     * use an index sidecar in standard mode: local file headers are loaded from it when it matches
+     * the archive, otherwise they are parsed and a fresh index is written
+     * @param path path of the index, empty to disable
+     */
+    void setIndexPath(const std::string& path) { index_path = path; }
+
+    /**
+     * keep the central directory as raw records instead of decoded headers (standard mode)
+     * fields are decoded on access, so memory stays close to the on-disk size of the directory
+     */
+    void setCompactDirectory(bool compact) { compact_directory = compact; }
+
     bool parse();
-    uint16_t parseStream();
+    uint64_t parseStream();
     bool parseStandard();
 
     /* ++++ commands ++++ */
     void printLocalFileHeaders() const;
-    void printLocalFileHeaders(uint16_t index) const;
+    void printLocalFileHeaders(size_t index) const;
     void printCentralDirectoryHeaders() const;
-    void printCentralDirectoryHeaders(uint16_t index) const;
+    void printCentralDirectoryHeaders(size_t index) const;
     void printEndOfCentralDirectoryRecord() const;
 
     void listLocalFileHeaders() const;
     void listCentralDirectoryHeaders() const;
 
-    bool addLocalFileHeader();
-    bool addCentralDirectoryHeader();
+    /**
+     * look up headers by filename through the hash index built at parse time
+     * @return indices of all headers with exactly this name, more than one for duplicates
+     */
+    std::vector<size_t> findLocalFileHeaders(std::string_view name) const;
+    std::vector<size_t> findCentralDirectoryHeaders(std::string_view name) const;
+    /* report every name that more than one header carries */
+    void printDuplicateNames() const;
+
+    /**
+     * decompress every entry on the worker threads and check its CRC-32 and size against the central
+     * directory (the local header or data descriptor in stream mode), reporting each mismatch
+     * @return true if no entry failed; encrypted entries and unknown methods are skipped, not failed
+     */
+    bool verify() const;
+
+    /**
+     * decompress one entry into a file, checking its CRC-32 and size while it is written
+     * the entry is streamed in bounded windows, stored data is copied by the kernel
+     * @param target index of the entry or its name
+     * @param dest output file, or an existing directory that receives the entry under its base name
+     * @return true if the entry was written and matched its checksum, a bad output file is removed
+     */
+    bool extract(const std::string& target, const std::string& dest) const;
 
+    /**
+     * extract every entry below a directory on the worker threads
+     * the directory tree is created up front from the name tree, then entries are written largest
+     * first by a work-stealing pool, each worker with its own decoder and positioned writes
+     * names that are absolute or climb out with ".." are refused, of duplicate names the last entry wins
+     * @return true if every entry that was not refused was written and matched its checksum
+     */
+    bool extractAll(const std::string& dir) const;
+
+    /**
+     * stream the uncompressed bytes of one entry into a file descriptor, normally stdout
+     * memory stays bounded by the decoder windows and stored data is passed on by the kernel; when the
+     * reader of a pipe goes away (EPIPE, SIGPIPE must be ignored) the rest of the entry is not decoded
+     * @param target index of the entry or its name
+     * @return false if the entry could not be found, decoded or written, or failed its checksum;
+     *         a closed pipe is not an error
+     */
+    bool cat(const std::string& target, int fd) const;
+
+    /* directory trees over the entry names, rows are header indices */
+    const NameTrie& getLocalFileHeaderTree() const {
+        ensureIndexes();
+        return local_file_header_tree;
+    }
+    const NameTrie& getCentralDirectoryHeaderTree() const {
+        ensureIndexes();
+        return central_directory_header_tree;
+    }
+    /* the tree to browse: the central directory one, or the local one in stream mode */
+    const NameTrie& getNameTree() const {
+        ensureIndexes();
+        return central_directory_header_tree.empty() ? local_file_header_tree : central_directory_header_tree;
+    }
+    /* list only the given headers, in the format of the full listings */
+    void listLocalFileHeaders(const std::vector<size_t>& rows) const;
+    void listCentralDirectoryHeaders(const std::vector<size_t>& rows) const;
+
+    /* columnar copy of the central directory for whole-archive queries, empty in stream mode */
+    const CentralDirectoryIndex& getCentralDirectoryIndex() const {
+        ensureIndexes();
+        return central_directory_index;
+    }
+
+    /**
+     * add files, and directories with everything below them, from disk as new entries
+     * file data is compressed into a scratch file next to the archive, large files in independent
+     * blocks on the worker threads with the CRC-32 taken in the same pass; each entry gets a local
+     * header placed after the last existing entry and a central directory record, and the end records
+     * are rewritten for the grown directory, so the entries can be verified, extracted and saved at once
+     * @param paths files or directories, stored under their relative path
+     * @return true if every path was added; names already in the archive are refused
+     */
+    bool addEntries(const std::vector<std::string>& paths);
+
+    /**
+     * write the archive to output_path
+     * saving new entries into the archive that was parsed appends them after the last entry and
+     * rewrites only the central directory and end records in place, then parses the archive again;
+     * everything else is written to a fresh file
+     */
     bool save(const std::string& output_path);
     /* ---- commands ---- */
 
+    /* central directory entries and their names, whether decoded or kept compact */
+    size_t getCentralDirectoryHeaderCount() const;
+    std::string_view getCentralDirectoryHeaderName(size_t index) const;
+
     void print() const;
     void writeToFile();
+    /* the central directory and end records, the tail of writeToFile */
+    void writeCentralDirectory();
 
 private:
+    /* mapped variants of the parsers, segments keep views into the mapping */
+    uint64_t parseStreamMapped();
+    bool parseStandardMapped();
+
+    /**
+     * locate and read the EOCD and, when a locator precedes it, the ZIP64 EOCD record
+     * @param record_pos receives the position of the EOCD
+     * @return true if the EOCD (and the ZIP64 record it points to, if any) was read
+     */
+    bool readEndRecords(std::streampos& record_pos);
+
+    /**
+     * decode the local file header of every central directory header from the mapping with a pool of workers
+     * results land in central directory order
+     */
+    bool parseLocalFileHeadersParallel();
+
+    /**
+     * read the local file header of every central directory header through an I/O plan
+     * reads are sorted by offset and coalesced into large sequential reads, batches are spread across
+     * the workers, each issuing its own positioned reads; results are mapped back to central directory order
+     */
+    bool parseLocalFileHeadersPlanned();
+
+    /**
+     * stream mode with a pool of workers: the file is cut into chunks, every worker searches its chunks
+     * for local file header signatures and decodes each candidate, a candidate is valid if its data
+     * ends on another record; the chain starting at the first byte is then stitched together
+     * @return number of local file headers in the chain, the same ones the sequential scan finds
+     */
+    uint64_t parseStreamParallel();
+
+    /**
+     * stream mode: settle the data size of a bit 3 entry and read its data descriptor
+     * when the local header has no size the data is scanned for the record that follows it
+     */
+    bool resolveDataDescriptor(LocalFileHeader& header) const;
+
+    /* central directory location and size, taken from the ZIP64 record where the EOCD is escaped */
+    uint64_t getCentralDirOffset() const;
+    uint64_t getCentralDirSize() const;
+    uint64_t getCentralDirRecordCount() const;
+
+    /**
+     * decode all central directory headers from a contiguous buffer
+     * @param data buffer starting at the central directory offset
+     * @param size number of bytes available in the buffer
+     * @return true if every record announced by the EOCD was decoded
+     */
+    bool decodeCentralDirectory(const uint8_t* data, size_t size);
+
+    /* entry index from a name, "#N" or a decimal index no entry is named after; reported on std::cerr when there is none */
+    bool resolveEntry(const std::string& target, size_t& index) const;
+    /* CRC-32 and uncompressed size an entry has to decode to */
+    void getExpectedChecksum(size_t index, uint32_t& crc, uint64_t& size) const;
+    /**
+     * decode an entry into a new file at path and check it, the file is removed if anything went wrong
+     * @param size bytes written
+     * @param message what went wrong
+     */
+    bool writeEntry(EntryDecoder& decoder, size_t index, const std::string& path, uint64_t& size,
+                    std::string& message) const;
+
+    /* create the scratch file that holds the data of added entries until they are saved */
+    bool openStaging();
+    /* add one file or directory, data is appended to the scratch file */
+    bool addEntry(const std::string& path, const std::string& name, EntryEncoder& encoder);
+    /* point the end records at the central directory as it will be written after the added entries */
+    void updateEndRecords();
+
+    /* whether save can append to output_path: it is the parsed archive, unchanged, and entries were added */
+    bool canSaveInPlace(const std::string& output_path) const;
+    /* write the added entries, the new directory and end records after the end of the archive */
+    bool saveInPlace(const std::string& output_path);
+    /* drop every parsed structure and the added entries and parse the archive again */
+    bool reload();
+
+    /*
+     * lookup structures derived from the parsed headers, to be refreshed whenever the header lists change
+     * compact mode keeps memory close to the directory itself and builds them when a command first needs them
+     */
+    void refreshIndexes();
+    void ensureIndexes() const;
+    void buildIndexes() const;
+
+    /* number of bytes to slurp for the central directory starting at its offset */
+    uint64_t centralDirectoryReadSize(std::streampos record_pos) const;
+
+    /* hash of the archive from the central directory offset to the end of the file, see ZipIndex */
+    bool hashDirectory(uint64_t& hash) const;
+
+    /**
+     * standard mode with an index sidecar, called once the central directory is decoded
+     * @return true if the local file headers were loaded from a matching index
+     */
+    bool loadLocalFileHeadersFromIndex(uint64_t directory_hash);
+    /* write the index for the headers just parsed, failure only costs the next run a full parse */
+    void saveIndex(uint64_t directory_hash) const;
+    /* standard mode after the central directory: index, planned, parallel or mapped local header parsing */
+    bool parseLocalFileHeaders();
+    /* decode local file headers in place from the mapping, one after the other */
+    bool parseLocalFileHeadersMapped();
+
     std::ifstream file;
     std::ofstream output_file;
     std::string parse_mode;
+    unsigned jobs = 1;
+    /* must outlive the segments below, which may view into its mapping */
+    ZipSource source;
+    std::string source_path;
+    /* unlinked scratch file with the data of added entries, their file data regions point into it */
+    ZipSource staging;
+    uint64_t staging_size = 0;
+    /* where the first and the next added entry go: after the last entry, where the central directory started */
+    uint64_t append_start = 0;
+    uint64_t append_offset = 0;
+    /* entries added since the archive was parsed, they are the last local file headers */
+    size_t added_entry_count = 0;
+    /* what their central directory records were built from, re-encoded when they land elsewhere */
+    std::vector<NewEntry> added_entries;
+    /* filenames and extra fields of headers read through copies, also must outlive the segments */
+    MetadataArena metadata_arena;
+    std::string index_path;
+    /* local file headers loaded from the index view into its mapping */
+    ZipIndex index;
+    /* central directory bytes read in one go when the archive is not mapped, CDHs view into it */
+    std::vector<uint8_t> central_dir_buffer;
     std::vector<LocalFileHeader> local_file_headers;
+    /* every record of the on-disk central directory, decoded headers are only kept when not compact */
+    CompactCentralDirectory central_directory_records;
     std::vector<CentralDirectoryHeader> central_directory_headers;
+    /* built from the headers above on demand, hence mutable */
+    mutable CentralDirectoryIndex central_directory_index;
+    mutable FilenameIndex local_file_header_names;
+    mutable FilenameIndex central_directory_header_names;
+    mutable NameTrie local_file_header_tree;
+    mutable NameTrie central_directory_header_tree;
+    mutable bool indexes_built = false;
     EndOfCentralDirectoryRecord end_of_central_directory_record;
-    uint16_t local_file_header_count;
+    Zip64EndOfCentralDirectoryRecord zip64_end_of_central_directory_record;
+    Zip64EndOfCentralDirectoryLocator zip64_end_of_central_directory_locator;
+    bool has_zip64_records = false;
+    bool compact_directory = false;
+    uint64_t local_file_header_count;
 };
 
 #endif /* ZIP_HANDLER_HPP */
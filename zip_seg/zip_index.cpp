@@ -0,0 +1,203 @@
+#include "zip_index.hpp"
+#include "buffer_reader.hpp"
+#include <cstdio>
+#include <algorithm>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace {
+
+/* number of bytes the raw local file header takes */
+size_t headerLength(const LocalFileHeader& header) {
+    return LocalFileHeader::FIXED_SIZE + header.getFilenameLength() + header.getExtraFieldLength();
+}
+
+size_t descriptorLength(const LocalFileHeader& header) {
+    return header.hasDataDescriptor() ? header.getDataDescriptor().getSize() : 0;
+}
+
+/* encode the raw header and descriptor bytes of an entry, as they appear in the archive */
+void encodeEntry(const LocalFileHeader& header, std::vector<uint8_t>& out) {
+    out.resize(headerLength(header) + descriptorLength(header));
+    uint8_t* p = out.data();
+    storeLittleEndian<uint32_t>(p, header.getSignature());
+    storeLittleEndian<uint16_t>(p + 4, header.getVersionNeeded());
+    storeLittleEndian<uint16_t>(p + 6, header.getGeneralBitFlag());
+    storeLittleEndian<uint16_t>(p + 8, header.getCompressionMethod());
+    storeLittleEndian<uint16_t>(p + 10, header.getLastModTime());
+    storeLittleEndian<uint16_t>(p + 12, header.getLastModDate());
+    storeLittleEndian<uint32_t>(p + 14, header.getCrc32());
+    storeLittleEndian<uint32_t>(p + 18, header.getCompressedSize());
+    storeLittleEndian<uint32_t>(p + 22, header.getUncompressedSize());
+    storeLittleEndian<uint16_t>(p + 26, header.getFilenameLength());
+    storeLittleEndian<uint16_t>(p + 28, header.getExtraFieldLength());
+    p += LocalFileHeader::FIXED_SIZE;
+
+    std::string_view filename = header.getFilename();
+    std::copy(filename.begin(), filename.end(), p);
+    p += header.getFilenameLength();
+    if (header.getExtraFieldLength() > 0) {
+        std::copy(header.getExtraField(), header.getExtraField() + header.getExtraFieldLength(), p);
+        p += header.getExtraFieldLength();
+    }
+
+    if (header.hasDataDescriptor()) {
+        const DataDescriptor& descriptor = header.getDataDescriptor();
+        if (descriptor.hasSignature()) {
+            storeLittleEndian<uint32_t>(p, DATA_DESCRIPTOR_SIG);
+            p += 4;
+        }
+        storeLittleEndian<uint32_t>(p, descriptor.getCrc32());
+        if (descriptor.isZip64()) {
+            storeLittleEndian<uint64_t>(p + 4, descriptor.getCompressedSize());
+            storeLittleEndian<uint64_t>(p + 12, descriptor.getUncompressedSize());
+        } else {
+            storeLittleEndian<uint32_t>(p + 4, static_cast<uint32_t>(descriptor.getCompressedSize()));
+            storeLittleEndian<uint32_t>(p + 8, static_cast<uint32_t>(descriptor.getUncompressedSize()));
+        }
+    }
+}
+
+} /* namespace */
+
+bool ZipIndex::open(const std::string& path) {
+    if (!file.open(path, true) || file.getSize() < HEADER_SIZE) {
+        file.close();
+        return false;
+    }
+
+    BufferReader reader(file.getData(), static_cast<size_t>(file.getSize()));
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint64_t mtime = 0;
+    bool ok = reader.read(magic) && magic == MAGIC &&
+              reader.read(version) && version == VERSION &&
+              reader.read(archive_size) &&
+              reader.read(mtime) &&
+              reader.read(directory_hash) &&
+              reader.read(entry_count) &&
+              reader.read(table_offset) &&
+              reader.read(blob_offset) &&
+              reader.read(blob_size);
+    archive_mtime = static_cast<int64_t>(mtime);
+
+    /* the table and the blob must lie inside the file */
+    uint64_t size = file.getSize();
+    ok = ok && table_offset <= size && entry_count <= (size - table_offset) / ENTRY_SIZE &&
+         blob_offset <= size && blob_size <= size - blob_offset;
+    if (!ok) {
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+bool ZipIndex::matches(const ZipSource& archive, uint64_t directory_hash, uint64_t entry_count) const {
+    return file.isOpen() &&
+           archive.getSize() == archive_size &&
+           archive.getModificationTime() == archive_mtime &&
+           directory_hash == this->directory_hash &&
+           entry_count == this->entry_count;
+}
+
+bool ZipIndex::loadLocalFileHeader(size_t index, const ZipSource* archive, LocalFileHeader& header) const {
+    if (index >= entry_count) {
+        return false;
+    }
+    const uint8_t* entry = file.getData() + table_offset + index * ENTRY_SIZE;
+    uint64_t header_offset = loadLittleEndian<uint64_t>(entry);
+    uint64_t data_size = loadLittleEndian<uint64_t>(entry + 8);
+    uint64_t blob_pos = loadLittleEndian<uint64_t>(entry + 16);
+    uint32_t header_length = loadLittleEndian<uint32_t>(entry + 24);
+    uint32_t descriptor_length = loadLittleEndian<uint32_t>(entry + 28);
+    if (blob_pos > blob_size || header_length + static_cast<uint64_t>(descriptor_length) > blob_size - blob_pos) {
+        return false;
+    }
+
+    /* decode in place, the base offset puts the file data where it is in the archive */
+    const uint8_t* bytes = file.getData() + blob_offset + blob_pos;
+    BufferReader reader(bytes, header_length, 0, header_offset);
+    if (!header.readFromBuffer(reader)) {
+        return false;
+    }
+    header.setFileDataSize(data_size);
+    if (!header.attachDataSource(archive)) {
+        return false;
+    }
+    if (descriptor_length > 0) {
+        header.readDataDescriptor(bytes + header_length, descriptor_length, data_size);
+    }
+    return true;
+}
+
+bool ZipIndex::write(const std::string& path, const ZipSource& archive, uint64_t directory_hash,
+                     const std::vector<LocalFileHeader>& headers) {
+    /* a unique name next to the sidecar, so concurrent writers never share one and the rename stays atomic */
+    std::vector<char> temp_name(path.begin(), path.end());
+    const char suffix[] = ".XXXXXX";
+    temp_name.insert(temp_name.end(), suffix, suffix + sizeof(suffix));
+    int fd = mkostemp(temp_name.data(), O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    std::string temp_path(temp_name.data());
+    /* mkostemp creates the file private to the owner, the index gets the usual 0644 */
+    fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    FILE* out = fdopen(fd, "wb");
+    if (out == nullptr) {
+        close(fd);
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    bool ok = true;
+
+    uint64_t table_offset = HEADER_SIZE;
+    uint64_t blob_offset = table_offset + headers.size() * ENTRY_SIZE;
+    uint64_t blob_size = 0;
+    for (const auto& header : headers) {
+        blob_size += headerLength(header) + descriptorLength(header);
+    }
+
+    uint8_t fixed[HEADER_SIZE];
+    storeLittleEndian<uint32_t>(fixed, MAGIC);
+    storeLittleEndian<uint32_t>(fixed + 4, VERSION);
+    storeLittleEndian<uint64_t>(fixed + 8, archive.getSize());
+    storeLittleEndian<uint64_t>(fixed + 16, static_cast<uint64_t>(archive.getModificationTime()));
+    storeLittleEndian<uint64_t>(fixed + 24, directory_hash);
+    storeLittleEndian<uint64_t>(fixed + 32, headers.size());
+    storeLittleEndian<uint64_t>(fixed + 40, table_offset);
+    storeLittleEndian<uint64_t>(fixed + 48, blob_offset);
+    storeLittleEndian<uint64_t>(fixed + 56, blob_size);
+    ok = ok && std::fwrite(fixed, 1, sizeof(fixed), out) == sizeof(fixed);
+
+    /* table */
+    uint64_t blob_pos = 0;
+    for (const auto& header : headers) {
+        uint8_t entry[ENTRY_SIZE];
+        size_t header_length = headerLength(header);
+        size_t descriptor_length = descriptorLength(header);
+        storeLittleEndian<uint64_t>(entry, header.getFileData().getOffset() - header_length);
+        storeLittleEndian<uint64_t>(entry + 8, header.getFileData().getSize());
+        storeLittleEndian<uint64_t>(entry + 16, blob_pos);
+        storeLittleEndian<uint32_t>(entry + 24, static_cast<uint32_t>(header_length));
+        storeLittleEndian<uint32_t>(entry + 28, static_cast<uint32_t>(descriptor_length));
+        ok = ok && std::fwrite(entry, 1, sizeof(entry), out) == sizeof(entry);
+        blob_pos += header_length + descriptor_length;
+    }
+
+    /* blob */
+    std::vector<uint8_t> record;
+    for (const auto& header : headers) {
+        encodeEntry(header, record);
+        ok = ok && std::fwrite(record.data(), 1, record.size(), out) == record.size();
+    }
+
+    ok = std::fclose(out) == 0 && ok;
+    if (!ok || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
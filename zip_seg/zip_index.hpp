@@ -0,0 +1,78 @@
+#ifndef ZIP_INDEX_HPP
+#define ZIP_INDEX_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "zip_seg.hpp"
+#include "zip_source.hpp"
+
+/**
+ * on-disk cache of the local file headers of an archive, stored next to it as <archive>.zidx
+ * the central directory is cheap to decode from one read, the local headers are not: they are
+ * scattered over the whole archive, so the index keeps their raw bytes in one mappable file
+ *
+ * layout, all integers little endian:
+ *   header   magic, version, archive size, archive mtime, directory hash, entry count,
+ *            table offset, blob offset, blob size (HEADER_SIZE bytes)
+ *   table    one ENTRY_SIZE record per local file header, in central directory order:
+ *            header offset, data size, blob position, header length, descriptor length
+ *   blob     raw local file header bytes, each followed by its data descriptor bytes
+ *
+ * an index is only used if the archive size, mtime and the hash of everything from the
+ * central directory to the end of the file are unchanged
+ */
+class ZipIndex {
+public:
+    static constexpr uint32_t MAGIC = 0x5844495a; /* "ZIDX" */
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 64;
+    static constexpr size_t ENTRY_SIZE = 32;
+
+    /* path of the sidecar belonging to an archive */
+    static std::string sidecarPath(const std::string& archive_path) { return archive_path + ".zidx"; }
+
+    /**
+     * map an index file and check its header and table bounds
+     * @return false if there is no index or it is not a well-formed one
+     */
+    bool open(const std::string& path);
+
+    /* whether the index was built from this very archive state */
+    bool matches(const ZipSource& archive, uint64_t directory_hash, uint64_t entry_count) const;
+
+    uint64_t getEntryCount() const { return entry_count; }
+
+    /**
+     * rebuild a local file header from the index, filename and extra field view into the index mapping
+     * @param index position in central directory order
+     * @param archive source the file data is read from
+     * @param header receives the decoded header
+     * @return false if the entry is malformed or its data does not fit in the archive
+     */
+    bool loadLocalFileHeader(size_t index, const ZipSource* archive, LocalFileHeader& header) const;
+
+    /**
+     * write a new index for an archive, through a temporary file that is renamed into place
+     * @param path path of the index file
+     * @param archive archive the headers were parsed from
+     * @param directory_hash hash of the central directory through the end of the archive
+     * @param headers local file headers in central directory order
+     * @return true if the index was written
+     */
+    static bool write(const std::string& path, const ZipSource& archive, uint64_t directory_hash,
+                      const std::vector<LocalFileHeader>& headers);
+
+private:
+    ZipSource file;
+    uint64_t archive_size = 0;
+    int64_t archive_mtime = 0;
+    uint64_t directory_hash = 0;
+    uint64_t entry_count = 0;
+    uint64_t table_offset = 0;
+    uint64_t blob_offset = 0;
+    uint64_t blob_size = 0;
+};
+
+#endif /* ZIP_INDEX_HPP */
@@ -1,8 +1,229 @@
 #include "zip_seg.hpp"
 #include "utils.hpp"
 #include "defs.hpp"
+#include "sig_scan.hpp"
 #include <iostream>
 #include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+void LocalFileHeader::resolveZip64() {
+    zip64_compressed_size = compressed_size;
+    zip64_uncompressed_size = uncompressed_size;
+
+    ExtraRecord record;
+    if (!ExtraField(extra_field, extra_field_length).find(ZIP64_EXTRA_FIELD_ID, record)) {
+        return;
+    }
+
+    /* the local record must carry both sizes, but tolerate writers that only store the escaped ones */
+    Zip64ExtraField field;
+    if (record.size >= 16) {
+        field.decode(record, true, true, false, false);
+    } else {
+        field.decode(record, uncompressed_size == ZIP64_ESCAPE_32, compressed_size == ZIP64_ESCAPE_32, false, false);
+    }
+    if (field.has_uncompressed_size) {
+        zip64_uncompressed_size = field.uncompressed_size;
+    }
+    if (field.has_compressed_size) {
+        zip64_compressed_size = field.compressed_size;
+    }
+}
+
+void CentralDirectoryHeader::resolveZip64() {
+    zip64_compressed_size = compressed_size;
+    zip64_uncompressed_size = uncompressed_size;
+    zip64_local_header_offset = local_header_offset;
+    zip64_disk_number_start = disk_number_start;
+
+    ExtraRecord record;
+    if (!ExtraField(extra_field, extra_field_length).find(ZIP64_EXTRA_FIELD_ID, record)) {
+        return;
+    }
+
+    /* only the escaped fields are present, always in this order */
+    Zip64ExtraField field;
+    field.decode(record, uncompressed_size == ZIP64_ESCAPE_32, compressed_size == ZIP64_ESCAPE_32,
+                 local_header_offset == ZIP64_ESCAPE_32, disk_number_start == ZIP64_ESCAPE_16);
+    if (field.has_uncompressed_size) {
+        zip64_uncompressed_size = field.uncompressed_size;
+    }
+    if (field.has_compressed_size) {
+        zip64_compressed_size = field.compressed_size;
+    }
+    if (field.has_local_header_offset) {
+        zip64_local_header_offset = field.local_header_offset;
+    }
+    if (field.has_disk_number_start) {
+        zip64_disk_number_start = field.disk_number_start;
+    }
+}
+
+bool LocalFileHeader::isZip64() const {
+    ExtraRecord record;
+    return ExtraField(extra_field, extra_field_length).find(ZIP64_EXTRA_FIELD_ID, record);
+}
+
+void DataDescriptor::print() const {
+    std::cout << "Data Descriptor Information:" << std::endl;
+    if (has_signature) {
+        std::cout << "  Signature: 0x" << std::hex << signature << std::dec << std::endl;
+    }
+    std::cout << "  CRC32: 0x" << std::hex << crc32 << std::dec << std::endl;
+    std::cout << "  Compressed Size: " << compressed_size << " bytes" << std::endl;
+    std::cout << "  Uncompressed Size: " << uncompressed_size << " bytes" << std::endl;
+}
+
+bool DataDescriptor::readFromFile(std::ifstream& file) {
+    if (!file.is_open() || !file.good()) {
+        return false;
+    }
+
+    /* signature is optional, without it the first field is the crc */
+    uint32_t first = readLittleEndian<uint32_t>(file);
+    has_signature = first == DATA_DESCRIPTOR_SIG;
+    if (has_signature) {
+        signature = first;
+        crc32 = readLittleEndian<uint32_t>(file);
+    } else {
+        signature = 0;
+        crc32 = first;
+    }
+
+    if (zip64) {
+        compressed_size = readLittleEndian<uint64_t>(file);
+        uncompressed_size = readLittleEndian<uint64_t>(file);
+    } else {
+        compressed_size = readLittleEndian<uint32_t>(file);
+        uncompressed_size = readLittleEndian<uint32_t>(file);
+    }
+    return !file.fail();
+}
+
+bool DataDescriptor::readFromBuffer(BufferReader& reader) {
+    size_t start = reader.getPosition();
+
+    uint32_t first = 0;
+    if (!reader.read(first)) {
+        return false;
+    }
+    has_signature = first == DATA_DESCRIPTOR_SIG;
+    signature = has_signature ? first : 0;
+
+    bool ok = true;
+    if (has_signature) {
+        ok = reader.read(crc32);
+    } else {
+        crc32 = first;
+    }
+    if (zip64) {
+        ok = ok && reader.read(compressed_size) && reader.read(uncompressed_size);
+    } else {
+        uint32_t compressed = 0;
+        uint32_t uncompressed = 0;
+        ok = ok && reader.read(compressed) && reader.read(uncompressed);
+        compressed_size = compressed;
+        uncompressed_size = uncompressed;
+    }
+    if (!ok) {
+        reader.seek(start);
+        return false;
+    }
+    return true;
+}
+
+bool DataDescriptor::writeToFile(std::ofstream& file) const {
+    if (!file.is_open() || !file.good()) {
+        return false;
+    }
+    try {
+        if (has_signature) {
+            writeLittleEndian<uint32_t>(file, signature);
+        }
+        writeLittleEndian<uint32_t>(file, crc32);
+        if (zip64) {
+            writeLittleEndian<uint64_t>(file, compressed_size);
+            writeLittleEndian<uint64_t>(file, uncompressed_size);
+        } else {
+            writeLittleEndian<uint32_t>(file, static_cast<uint32_t>(compressed_size));
+            writeLittleEndian<uint32_t>(file, static_cast<uint32_t>(uncompressed_size));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error while writing DataDescriptor to file: " << e.what() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool DataDescriptor::locate(const ZipSource& source, uint64_t data_start, bool zip64, uint64_t& data_size) {
+    const size_t chunk_size = 1024 * 1024;
+    const uint64_t body_size = zip64 ? 20 : 12;
+    const uint64_t file_size = source.getSize();
+
+    /* a candidate ends the file data if the descriptor in front of it declares exactly that many bytes */
+    auto accepts = [&](uint64_t pos, uint32_t signature) {
+        uint64_t body_pos = 0;
+        uint64_t size = 0;
+        if (signature == DATA_DESCRIPTOR_SIG) {
+            body_pos = pos + 4;
+            size = pos - data_start;
+        } else if (signature == LOCAL_FILE_HEADER_SIG || signature == CENTRAL_DIRECTORY_HEADER_SIG ||
+                   signature == END_OF_CENTRAL_DIRECTORY_SIG || signature == ZIP64_END_OF_CENTRAL_DIRECTORY_SIG) {
+            /* the next record may follow a descriptor written without signature */
+            if (pos - data_start < body_size) {
+                return false;
+            }
+            body_pos = pos - body_size;
+            size = body_pos - data_start;
+        } else {
+            return false;
+        }
+
+        uint8_t body[20];
+        if (body_pos + body_size > file_size || !source.readAt(body_pos, body, static_cast<size_t>(body_size))) {
+            return false;
+        }
+        uint64_t declared = zip64 ? loadLittleEndian<uint64_t>(body + 4) : loadLittleEndian<uint32_t>(body + 4);
+        if (declared != size) {
+            return false;
+        }
+        data_size = size;
+        return true;
+    };
+
+    if (source.isMapped()) {
+        const uint8_t* data = source.getData();
+        size_t pos = static_cast<size_t>(data_start);
+        while ((pos = findMarkerForward(data, static_cast<size_t>(file_size), pos)) != SIG_NOT_FOUND) {
+            if (accepts(pos, loadLittleEndian<uint32_t>(data + pos))) {
+                return true;
+            }
+            ++pos;
+        }
+        return false;
+    }
+
+    /* consecutive chunks overlap by three bytes so that no signature straddles a boundary unseen */
+    std::vector<uint8_t> buffer(chunk_size + 3);
+    uint64_t chunk_start = data_start;
+    while (chunk_start + 3 < file_size) {
+        size_t length = static_cast<size_t>(std::min<uint64_t>(buffer.size(), file_size - chunk_start));
+        if (!source.readAt(chunk_start, buffer.data(), length)) {
+            return false;
+        }
+        size_t pos = 0;
+        while ((pos = findMarkerForward(buffer.data(), length, pos)) != SIG_NOT_FOUND) {
+            if (accepts(chunk_start + pos, loadLittleEndian<uint32_t>(buffer.data() + pos))) {
+                return true;
+            }
+            ++pos;
+        }
+        chunk_start += length - 3;
+    }
+    return false;
+}
 
 void LocalFileHeader::print() const {
     std::cout << "Local File Header Information:" << std::endl;
@@ -18,12 +239,33 @@ void LocalFileHeader::print() const {
     std::cout << "  Filename Length: " << filename_length << " bytes" << std::endl;
     std::cout << "  Extra Field Length: " << extra_field_length << " bytes" << std::endl;
 
+    if (zip64_compressed_size != compressed_size) {
+        std::cout << "  ZIP64 Compressed Size: " << zip64_compressed_size << " bytes" << std::endl;
+    }
+    if (zip64_uncompressed_size != uncompressed_size) {
+        std::cout << "  ZIP64 Uncompressed Size: " << zip64_uncompressed_size << " bytes" << std::endl;
+    }
+
     if (filename_length > 0) {
         std::cout << "  Filename: " << filename << std::endl;
     }
+    ExtraField(extra_field, extra_field_length).print();
+
+    if (has_data_descriptor) {
+        data_descriptor.print();
+    }
 }
 
-bool LocalFileHeader::readFromFile(std::ifstream& file) {
+uint8_t* LocalFileHeader::allocateStorage(size_t size, MetadataArena* arena) {
+    if (arena != nullptr) {
+        owned_data.reset();
+        return arena->allocate(size);
+    }
+    owned_data = std::make_unique<uint8_t[]>(size);
+    return owned_data.get();
+}
+
+bool LocalFileHeader::readFromFile(std::ifstream& file, MetadataArena* arena) {
     if (!file.is_open() || !file.good()) {
         return false;
     }
@@ -47,25 +289,135 @@ bool LocalFileHeader::readFromFile(std::ifstream& file) {
     filename_length = readLittleEndian<uint16_t>(file);
     extra_field_length = readLittleEndian<uint16_t>(file);
 
-    /* read filename */
-    if (filename_length > 0) {
-        filename = std::string(filename_length, '\0');
-        file.read(&filename[0], filename_length);
+    /* filename and extra field are contiguous, read them with a single allocation */
+    size_t variable_length = static_cast<size_t>(filename_length) + extra_field_length;
+    if (variable_length > 0) {
+        uint8_t* storage = allocateStorage(variable_length, arena);
+        file.read(reinterpret_cast<char*>(storage), variable_length);
+
+        const uint8_t* cursor = storage;
+        filename = std::string_view(reinterpret_cast<const char*>(cursor), filename_length);
+        cursor += filename_length;
+        extra_field = extra_field_length > 0 ? cursor : nullptr;
+    }
+    if (file.fail()) {
+        return false;
+    }
+
+    resolveZip64();
+
+    /* remember where the file data is and skip over it */
+    std::streampos data_pos = file.tellg();
+    file_data = DataRegion(nullptr, static_cast<uint64_t>(data_pos), zip64_compressed_size);
+    file.seekg(static_cast<std::streamoff>(zip64_compressed_size), std::ios::cur);
+
+    return !file.fail();
+}
+
+bool LocalFileHeader::readFromBuffer(BufferReader& reader) {
+    size_t start = reader.getPosition();
+
+    /* read and check signature */
+    if (!reader.read(signature) || signature != LOCAL_FILE_HEADER_SIG) {
+        reader.seek(start);
+        return false;
     }
 
-    /* read extra field */
-    if (extra_field_length > 0) {
-        extra_field = std::make_unique<uint8_t[]>(extra_field_length);
-        file.read(reinterpret_cast<char*>(extra_field.get()), extra_field_length);
+    const uint8_t* name_view = nullptr;
+    bool ok = reader.read(version_needed) &&
+              reader.read(general_bit_flag) &&
+              reader.read(compression_method) &&
+              reader.read(last_mod_time) &&
+              reader.read(last_mod_date) &&
+              reader.read(crc32) &&
+              reader.read(compressed_size) &&
+              reader.read(uncompressed_size) &&
+              reader.read(filename_length) &&
+              reader.read(extra_field_length) &&
+              reader.readBytes(filename_length, name_view) &&
+              reader.readBytes(extra_field_length, extra_field);
+    if (!ok) {
+        reader.seek(start);
+        return false;
     }
 
-    /* read file data */
-    if (compressed_size > 0) {
-        file_data = std::make_unique<uint8_t[]>(compressed_size);
-        file.read(reinterpret_cast<char*>(file_data.get()), compressed_size);
+    filename = std::string_view(reinterpret_cast<const char*>(name_view), filename_length);
+    if (extra_field_length == 0) {
+        extra_field = nullptr;
     }
 
-    return !file.fail();
+    resolveZip64();
+
+    /* the file data may lie outside the buffer, only record its location */
+    file_data = DataRegion(nullptr, reader.getAbsolutePosition(), zip64_compressed_size);
+    reader.skip(static_cast<size_t>(std::min<uint64_t>(zip64_compressed_size, reader.remaining())));
+    return true;
+}
+
+bool LocalFileHeader::readFromSource(const ZipSource& source, uint64_t offset, MetadataArena* arena) {
+    /* the fixed part tells how long the variable part is */
+    uint8_t fixed[FIXED_SIZE];
+    if (!source.readAt(offset, fixed, FIXED_SIZE) || loadLittleEndian<uint32_t>(fixed) != LOCAL_FILE_HEADER_SIG) {
+        return false;
+    }
+    size_t header_size = FIXED_SIZE + loadLittleEndian<uint16_t>(fixed + 26) + loadLittleEndian<uint16_t>(fixed + 28);
+
+    /* read the whole header into stable storage and decode it there, the views stay valid after moves */
+    uint8_t* header = allocateStorage(header_size, arena);
+    std::memcpy(header, fixed, FIXED_SIZE);
+    if (!source.readAt(offset + FIXED_SIZE, header + FIXED_SIZE, header_size - FIXED_SIZE)) {
+        return false;
+    }
+    BufferReader reader(header, header_size, 0, offset);
+    return readFromBuffer(reader);
+}
+
+bool LocalFileHeader::readFromBufferCopy(const uint8_t* data, size_t size, uint64_t offset, MetadataArena* arena) {
+    if (size < FIXED_SIZE || loadLittleEndian<uint32_t>(data) != LOCAL_FILE_HEADER_SIG) {
+        return false;
+    }
+    size_t header_size = FIXED_SIZE + loadLittleEndian<uint16_t>(data + 26) + loadLittleEndian<uint16_t>(data + 28);
+    if (header_size > size) {
+        return false;
+    }
+
+    uint8_t* header = allocateStorage(header_size, arena);
+    std::memcpy(header, data, header_size);
+    BufferReader reader(header, header_size, 0, offset);
+    return readFromBuffer(reader);
+}
+
+bool LocalFileHeader::applyDataDescriptor(uint64_t data_size) {
+    const ZipSource* source = file_data.getSource();
+    if (source == nullptr) {
+        return false;
+    }
+    DataRegion region(nullptr, file_data.getOffset(), data_size);
+    if (!region.attach(source)) {
+        return false;
+    }
+    file_data = region;
+
+    uint64_t descriptor_pos = file_data.getOffset() + data_size;
+    uint8_t bytes[24];
+    size_t available = static_cast<size_t>(std::min<uint64_t>(sizeof(bytes), source->getSize() - descriptor_pos));
+    if (source->readAt(descriptor_pos, bytes, available)) {
+        readDataDescriptor(bytes, available, data_size);
+    }
+    return true;
+}
+
+bool LocalFileHeader::readDataDescriptor(const uint8_t* data, size_t size, uint64_t data_size) {
+    /* the descriptor is only trusted if it is signed or agrees with the size we were given */
+    DataDescriptor descriptor(isZip64());
+    BufferReader reader(data, size);
+    if (!descriptor.readFromBuffer(reader) ||
+        !(descriptor.hasSignature() || descriptor.getCompressedSize() == data_size)) {
+        return false;
+    }
+    data_descriptor = descriptor;
+    has_data_descriptor = true;
+    return true;
 }
 
 bool LocalFileHeader::writeToFile(std::ofstream& file) const {
@@ -87,17 +439,23 @@ bool LocalFileHeader::writeToFile(std::ofstream& file) const {
 
         /* write filename */
         if (filename_length > 0) {
-            file.write(filename.c_str(), filename_length);
+            file.write(filename.data(), filename_length);
         }
 
         /* write extra field */
         if (extra_field_length > 0) {
-            file.write(reinterpret_cast<const char*>(extra_field.get()), extra_field_length);
+            file.write(reinterpret_cast<const char*>(extra_field), extra_field_length);
+        }
+
+        /* stream file data from the source */
+        if (!file_data.copyTo(file)) {
+            std::cerr << "Error while copying file data of " << filename << std::endl;
+            return false;
         }
 
-        /* write file data if file_data is not null */
-        if (file_data != nullptr && compressed_size > 0) {
-            file.write(reinterpret_cast<const char*>(file_data.get()), compressed_size);
+        /* sizes and crc of bit 3 entries follow the data */
+        if (has_data_descriptor && !data_descriptor.writeToFile(file)) {
+            return false;
         }
     } catch (const std::exception& e) {
         std::cerr << "Error while writing LocalFileHeader to file: " << e.what() << std::endl;
@@ -128,12 +486,35 @@ void CentralDirectoryHeader::print() const {
     std::cout << "  External Attr: 0x" << std::hex << external_attr << std::dec << std::endl;
     std::cout << "  Local Header Offset: 0x" << std::hex << local_header_offset << std::dec << std::endl;
 
+    if (zip64_compressed_size != compressed_size) {
+        std::cout << "  ZIP64 Compressed Size: " << zip64_compressed_size << " bytes" << std::endl;
+    }
+    if (zip64_uncompressed_size != uncompressed_size) {
+        std::cout << "  ZIP64 Uncompressed Size: " << zip64_uncompressed_size << " bytes" << std::endl;
+    }
+    if (zip64_local_header_offset != local_header_offset) {
+        std::cout << "  ZIP64 Local Header Offset: 0x" << std::hex << zip64_local_header_offset << std::dec << std::endl;
+    }
+    if (zip64_disk_number_start != disk_number_start) {
+        std::cout << "  ZIP64 Disk Number Start: " << zip64_disk_number_start << std::endl;
+    }
+
     if (filename_length > 0) {
         std::cout << "  Filename: " << filename << std::endl;
     }
+    ExtraField(extra_field, extra_field_length).print();
+}
+
+uint8_t* CentralDirectoryHeader::allocateStorage(size_t size, MetadataArena* arena) {
+    if (arena != nullptr) {
+        owned_data.reset();
+        return arena->allocate(size);
+    }
+    owned_data = std::make_unique<uint8_t[]>(size);
+    return owned_data.get();
 }
 
-bool CentralDirectoryHeader::readFromFile(std::ifstream& file) {
+bool CentralDirectoryHeader::readFromFile(std::ifstream& file, MetadataArena* arena) {
     if (!file.is_open() || !file.good()) {
         return false;
     }
@@ -163,19 +544,70 @@ bool CentralDirectoryHeader::readFromFile(std::ifstream& file) {
     external_attr = readLittleEndian<uint32_t>(file);
     local_header_offset = readLittleEndian<uint32_t>(file);
 
-    /* read filename */
-    if (filename_length > 0) {
-        filename = std::string(filename_length, '\0');
-        file.read(&filename[0], filename_length);
+    /* filename, extra field and file comment are contiguous, read them with a single allocation */
+    size_t variable_length = static_cast<size_t>(filename_length) + extra_field_length + file_comment_length;
+    if (variable_length > 0) {
+        uint8_t* storage = allocateStorage(variable_length, arena);
+        file.read(reinterpret_cast<char*>(storage), variable_length);
+
+        const uint8_t* cursor = storage;
+        filename = std::string_view(reinterpret_cast<const char*>(cursor), filename_length);
+        cursor += filename_length;
+        extra_field = extra_field_length > 0 ? cursor : nullptr;
+        cursor += extra_field_length;
+        file_comment = std::string_view(reinterpret_cast<const char*>(cursor), file_comment_length);
+    }
+    if (file.fail()) {
+        return false;
+    }
+
+    resolveZip64();
+    return true;
+}
+
+bool CentralDirectoryHeader::readFromBuffer(BufferReader& reader) {
+    size_t start = reader.getPosition();
+
+    /* read and check signature */
+    if (!reader.read(signature) || signature != CENTRAL_DIRECTORY_HEADER_SIG) {
+        reader.seek(start);
+        return false;
     }
 
-    /* read extra field */
-    if (extra_field_length > 0) {
-        extra_field = std::make_unique<uint8_t[]>(extra_field_length);
-        file.read(reinterpret_cast<char*>(extra_field.get()), extra_field_length);
+    const uint8_t* name_view = nullptr;
+    const uint8_t* comment_view = nullptr;
+    bool ok = reader.read(version_made_by) &&
+              reader.read(version_needed) &&
+              reader.read(general_bit_flag) &&
+              reader.read(compression_method) &&
+              reader.read(last_mod_time) &&
+              reader.read(last_mod_date) &&
+              reader.read(crc32) &&
+              reader.read(compressed_size) &&
+              reader.read(uncompressed_size) &&
+              reader.read(filename_length) &&
+              reader.read(extra_field_length) &&
+              reader.read(file_comment_length) &&
+              reader.read(disk_number_start) &&
+              reader.read(internal_attr) &&
+              reader.read(external_attr) &&
+              reader.read(local_header_offset) &&
+              reader.readBytes(filename_length, name_view) &&
+              reader.readBytes(extra_field_length, extra_field) &&
+              reader.readBytes(file_comment_length, comment_view);
+    if (!ok) {
+        reader.seek(start);
+        return false;
     }
 
-    return !file.fail();
+    filename = std::string_view(reinterpret_cast<const char*>(name_view), filename_length);
+    file_comment = std::string_view(reinterpret_cast<const char*>(comment_view), file_comment_length);
+    if (extra_field_length == 0) {
+        extra_field = nullptr;
+    }
+
+    resolveZip64();
+    return true;
 }
 
 bool CentralDirectoryHeader::writeToFile(std::ofstream& file) const {
@@ -203,12 +635,17 @@ bool CentralDirectoryHeader::writeToFile(std::ofstream& file) const {
 
         /* write filename */
         if (filename_length > 0) {
-            file.write(filename.c_str(), filename_length);
+            file.write(filename.data(), filename_length);
         }
 
         /* write extra field */
         if (extra_field_length > 0) {
-            file.write(reinterpret_cast<const char*>(extra_field.get()), extra_field_length);
+            file.write(reinterpret_cast<const char*>(extra_field), extra_field_length);
+        }
+
+        /* write file comment */
+        if (file_comment_length > 0) {
+            file.write(file_comment.data(), file_comment_length);
         }
     } catch (const std::exception& e) {
         std::cerr << "Error while writing CentralDirectoryHeader to file: " << e.what() << std::endl;
@@ -264,6 +701,34 @@ bool EndOfCentralDirectoryRecord::readFromFile(std::ifstream& file) {
     return !file.fail();
 }
 
+bool EndOfCentralDirectoryRecord::readFromBuffer(BufferReader& reader) {
+    size_t start = reader.getPosition();
+
+    /* read and check signature */
+    if (!reader.read(signature) || signature != END_OF_CENTRAL_DIRECTORY_SIG) {
+        reader.seek(start);
+        return false;
+    }
+
+    const uint8_t* comment_view = nullptr;
+    bool ok = reader.read(disk_number) &&
+              reader.read(disk_with_central_dir_start) &&
+              reader.read(central_dir_record_count) &&
+              reader.read(total_central_dir_record_count) &&
+              reader.read(central_dir_size) &&
+              reader.read(central_dir_offset) &&
+              reader.read(zip_file_comment_length) &&
+              reader.readBytes(zip_file_comment_length, comment_view);
+    if (!ok) {
+        reader.seek(start);
+        return false;
+    }
+
+    /* the archive comment is tiny and unique, keep an owned copy */
+    zip_file_comment.assign(reinterpret_cast<const char*>(comment_view), zip_file_comment_length);
+    return true;
+}
+
 bool EndOfCentralDirectoryRecord::writeToFile(std::ofstream& file) const {
     if (!file.is_open() || !file.good()) {
         return false;
@@ -289,6 +754,17 @@ bool EndOfCentralDirectoryRecord::writeToFile(std::ofstream& file) const {
     return true;
 }
 
+bool EndOfCentralDirectoryRecord::update(uint64_t record_count, uint64_t central_dir_size,
+                                         uint64_t central_dir_offset) {
+    bool escaped = record_count >= ZIP64_ESCAPE_16 || central_dir_size >= ZIP64_ESCAPE_32 ||
+                   central_dir_offset >= ZIP64_ESCAPE_32;
+    central_dir_record_count = static_cast<uint16_t>(std::min<uint64_t>(record_count, ZIP64_ESCAPE_16));
+    total_central_dir_record_count = central_dir_record_count;
+    this->central_dir_size = static_cast<uint32_t>(std::min<uint64_t>(central_dir_size, ZIP64_ESCAPE_32));
+    this->central_dir_offset = static_cast<uint32_t>(std::min<uint64_t>(central_dir_offset, ZIP64_ESCAPE_32));
+    return escaped;
+}
+
 std::streampos EndOfCentralDirectoryRecord::findFromEnd(std::ifstream& file) {
     if (!file.is_open() || !file.good()) {
         return -1;
@@ -299,69 +775,275 @@ std::streampos EndOfCentralDirectoryRecord::findFromEnd(std::ifstream& file) {
 
     /* get file size */
     file.seekg(0, std::ios::end);
-    std::streampos file_size = file.tellg();
+    uint64_t file_size = static_cast<uint64_t>(file.tellg());
 
-    /* EndOfCentralDirectoryRecord minimum size is 22 bytes (excluding comment) */
-    /* Maximum comment length is 65535 bytes, so we search from the end of the file */
-    /* But we ensure we don't search beyond the first half of the file (to avoid over-searching) */
-    const size_t max_search_size = std::min(static_cast<size_t>(file_size) / 2, static_cast<size_t>(65535 + 22));
+    /* read search area content into buffer */
+    size_t tail_size = static_cast<size_t>(std::min<uint64_t>(file_size, MAX_SEARCH_SIZE));
+    std::vector<uint8_t> tail(tail_size);
+    file.seekg(static_cast<std::streamoff>(file_size - tail_size), std::ios::beg);
+    file.read(reinterpret_cast<char*>(tail.data()), tail_size);
+    bool read_ok = !file.fail();
 
-    /* search for EndOfCentralDirectoryRecord signature from end of file */
-    /* Leave minimum size of EndOfCentralDirectoryRecord (22 bytes) at the end of the search area */
-    std::streampos search_start_pos = file_size - static_cast<std::streampos>(max_search_size);
-    if (search_start_pos < 0) {
-        search_start_pos = 0;
+    /* recover file position */
+    file.clear();
+    file.seekg(original_pos, std::ios::beg);
+
+    if (!read_ok) {
+        return -1;
     }
+    return findInTail(tail.data(), tail_size, file_size);
+}
 
-    file.seekg(search_start_pos, std::ios::beg);
+std::streampos EndOfCentralDirectoryRecord::findFromEnd(const ZipSource& source) {
+    if (!source.isOpen()) {
+        return -1;
+    }
 
-    /* read search area content into buffer */
-    size_t buffer_size = static_cast<size_t>(file_size - search_start_pos);
-    std::vector<char> buffer(buffer_size);
-    file.read(buffer.data(), buffer_size);
+    uint64_t file_size = source.getSize();
+    size_t tail_size = static_cast<size_t>(std::min<uint64_t>(file_size, MAX_SEARCH_SIZE));
 
-    if (file.fail()) {
-        /* recover file position */
-        file.seekg(original_pos, std::ios::beg);
+    /* a mapped source is searched in place */
+    if (source.isMapped()) {
+        return findInTail(source.getData() + (file_size - tail_size), tail_size, file_size);
+    }
+
+    std::vector<uint8_t> tail(tail_size);
+    if (!source.readAt(file_size - tail_size, tail.data(), tail_size)) {
         return -1;
     }
+    return findInTail(tail.data(), tail_size, file_size);
+}
 
-    /* search for EndOfCentralDirectoryRecord signature from end of buffer */
-    const uint32_t signature = END_OF_CENTRAL_DIRECTORY_SIG;
-    const char* signature_bytes = reinterpret_cast<const char*>(&signature);
+std::streampos EndOfCentralDirectoryRecord::findInTail(const uint8_t* tail, size_t tail_size, uint64_t file_size) {
+    const uint64_t tail_offset = file_size - tail_size;
+    size_t fallback = SIG_NOT_FOUND;
 
-    for (size_t i = buffer_size - 4; i > 0; --i) {
-        bool signature_match = true;
-        for (size_t j = 0; j < 4; ++j) {
-            if (buffer[i + j] != signature_bytes[j]) {
-                signature_match = false;
-                break;
-            }
+    /* walk candidates from the end, the vectorized search skips everything that cannot match */
+    size_t limit = SIG_NOT_FOUND;
+    while (true) {
+        size_t pos = findSignatureReverse(tail, tail_size, END_OF_CENTRAL_DIRECTORY_SIG, limit);
+        if (pos == SIG_NOT_FOUND) {
+            break;
         }
+        limit = pos;
 
-        if (signature_match) {
-            /* found signature, calculate its absolute position in the file */
-            std::streampos record_pos = search_start_pos + static_cast<std::streampos>(i);
-
-            /* move file pointer to the start of the record */
-            file.seekg(record_pos, std::ios::beg);
+        /* the fixed part of the record must fit before EOF */
+        if (tail_size - pos < MIN_RECORD_SIZE) {
+            continue;
+        }
 
-            /* verify this is a valid record */
-            /* move file pointer to the start of the record and read signature to confirm */
-            file.seekg(record_pos, std::ios::beg);
-            uint32_t temp_signature = readLittleEndian<uint32_t>(file);
+        /* remember the last complete candidate in case none of them is fully consistent */
+        if (fallback == SIG_NOT_FOUND) {
+            fallback = pos;
+        }
 
-            /* recover file position */
-            file.seekg(original_pos, std::ios::beg);
+        /* validate the candidate in-buffer: the comment must end exactly at EOF */
+        /* and the central directory must lie between the start of the file and the record */
+        const uint8_t* record = tail + pos;
+        uint64_t comment_length = loadLittleEndian<uint16_t>(record + 20);
+        uint64_t dir_size = loadLittleEndian<uint32_t>(record + 12);
+        uint64_t dir_offset = loadLittleEndian<uint32_t>(record + 16);
+        uint64_t record_offset = tail_offset + pos;
 
-            /* if signature is valid, return the found position */
-            if (temp_signature == END_OF_CENTRAL_DIRECTORY_SIG) {
-                return record_pos;
-            }
+        bool comment_consistent = record_offset + MIN_RECORD_SIZE + comment_length == file_size;
+        /* ZIP64 archives store 0xFFFFFFFF here, the real values live in the ZIP64 record */
+        bool offset_consistent = dir_offset == 0xFFFFFFFF || dir_size == 0xFFFFFFFF ||
+                                 dir_offset + dir_size <= record_offset;
+        if (comment_consistent && offset_consistent) {
+            return static_cast<std::streamoff>(record_offset);
         }
     }
 
-    /* if no valid signature is found, recover file position */
-    file.seekg(original_pos, std::ios::beg);
+    /* crafted archives may not be consistent at all, fall back to the last signature */
+    if (fallback != SIG_NOT_FOUND) {
+        return static_cast<std::streamoff>(tail_offset + fallback);
+    }
     return -1;
 }
+
+void Zip64EndOfCentralDirectoryRecord::print() const {
+    std::cout << "ZIP64 End of Central Directory Record Information:" << std::endl;
+    std::cout << "  Signature: 0x" << std::hex << signature << std::dec << std::endl;
+    std::cout << "  Size of Record: " << size_of_record << " bytes" << std::endl;
+    std::cout << "  Version Made By: " << version_made_by << std::endl;
+    std::cout << "  Version Needed: " << version_needed << std::endl;
+    std::cout << "  Disk Number: " << disk_number << std::endl;
+    std::cout << "  Disk with Central Directory Start: " << disk_with_central_dir_start << std::endl;
+    std::cout << "  Central Directory Record Count: " << central_dir_record_count << std::endl;
+    std::cout << "  Total Central Directory Record Count: " << total_central_dir_record_count << std::endl;
+    std::cout << "  Central Directory Size: " << central_dir_size << " bytes" << std::endl;
+    std::cout << "  Central Directory Offset: 0x" << std::hex << central_dir_offset << std::dec << std::endl;
+    std::cout << "  Extensible Data Length: " << extensible_data.size() << " bytes" << std::endl;
+}
+
+bool Zip64EndOfCentralDirectoryRecord::readFromFile(std::ifstream& file) {
+    if (!file.is_open() || !file.good()) {
+        return false;
+    }
+
+    /* read the fixed part and decode it like a buffer */
+    uint8_t fixed[MIN_RECORD_SIZE];
+    file.read(reinterpret_cast<char*>(fixed), MIN_RECORD_SIZE);
+    if (file.fail()) {
+        return false;
+    }
+    BufferReader reader(fixed, MIN_RECORD_SIZE);
+    if (!readFromBuffer(reader)) {
+        return false;
+    }
+
+    /* read extensible data sector, declared by size_of_record */
+    uint64_t extensible_length = size_of_record - (MIN_RECORD_SIZE - 12);
+    if (extensible_length > 0) {
+        extensible_data = std::string(static_cast<size_t>(extensible_length), '\0');
+        file.read(&extensible_data[0], static_cast<std::streamsize>(extensible_length));
+    }
+
+    return !file.fail();
+}
+
+bool Zip64EndOfCentralDirectoryRecord::readFromBuffer(BufferReader& reader) {
+    size_t start = reader.getPosition();
+
+    /* read and check signature */
+    if (!reader.read(signature) || signature != ZIP64_END_OF_CENTRAL_DIRECTORY_SIG) {
+        reader.seek(start);
+        return false;
+    }
+
+    bool ok = reader.read(size_of_record) &&
+              reader.read(version_made_by) &&
+              reader.read(version_needed) &&
+              reader.read(disk_number) &&
+              reader.read(disk_with_central_dir_start) &&
+              reader.read(central_dir_record_count) &&
+              reader.read(total_central_dir_record_count) &&
+              reader.read(central_dir_size) &&
+              reader.read(central_dir_offset);
+    /* size_of_record excludes the leading 12 bytes and can never be smaller than the fixed fields */
+    if (!ok || size_of_record < MIN_RECORD_SIZE - 12) {
+        reader.seek(start);
+        return false;
+    }
+
+    /* the extensible data sector is optional in the buffer so that the fixed part can be decoded alone */
+    uint64_t extensible_length = size_of_record - (MIN_RECORD_SIZE - 12);
+    const uint8_t* extensible_view = nullptr;
+    if (extensible_length > 0 && extensible_length <= reader.remaining() &&
+        reader.readBytes(static_cast<size_t>(extensible_length), extensible_view)) {
+        extensible_data.assign(reinterpret_cast<const char*>(extensible_view), static_cast<size_t>(extensible_length));
+    }
+    return true;
+}
+
+bool Zip64EndOfCentralDirectoryRecord::writeToFile(std::ofstream& file) const {
+    if (!file.is_open() || !file.good()) {
+        return false;
+    }
+    try {
+        writeLittleEndian<uint32_t>(file, signature);
+        writeLittleEndian<uint64_t>(file, size_of_record);
+        writeLittleEndian<uint16_t>(file, version_made_by);
+        writeLittleEndian<uint16_t>(file, version_needed);
+        writeLittleEndian<uint32_t>(file, disk_number);
+        writeLittleEndian<uint32_t>(file, disk_with_central_dir_start);
+        writeLittleEndian<uint64_t>(file, central_dir_record_count);
+        writeLittleEndian<uint64_t>(file, total_central_dir_record_count);
+        writeLittleEndian<uint64_t>(file, central_dir_size);
+        writeLittleEndian<uint64_t>(file, central_dir_offset);
+
+        /* write extensible data sector */
+        if (!extensible_data.empty()) {
+            file.write(extensible_data.data(), static_cast<std::streamsize>(extensible_data.size()));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error while writing Zip64EndOfCentralDirectoryRecord to file: " << e.what() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void Zip64EndOfCentralDirectoryRecord::update(uint64_t record_count, uint64_t central_dir_size,
+                                              uint64_t central_dir_offset) {
+    if (signature != ZIP64_END_OF_CENTRAL_DIRECTORY_SIG) {
+        signature = ZIP64_END_OF_CENTRAL_DIRECTORY_SIG;
+        size_of_record = MIN_RECORD_SIZE - 12;
+        version_made_by = 45;
+        version_needed = 45;
+        disk_number = 0;
+        disk_with_central_dir_start = 0;
+        extensible_data.clear();
+    }
+    this->central_dir_record_count = record_count;
+    total_central_dir_record_count = record_count;
+    this->central_dir_size = central_dir_size;
+    this->central_dir_offset = central_dir_offset;
+}
+
+void Zip64EndOfCentralDirectoryLocator::update(uint64_t zip64_eocd_offset) {
+    if (signature != ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIG) {
+        signature = ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIG;
+        disk_with_zip64_eocd = 0;
+        total_disks = 1;
+    }
+    this->zip64_eocd_offset = zip64_eocd_offset;
+}
+
+void Zip64EndOfCentralDirectoryLocator::print() const {
+    std::cout << "ZIP64 End of Central Directory Locator Information:" << std::endl;
+    std::cout << "  Signature: 0x" << std::hex << signature << std::dec << std::endl;
+    std::cout << "  Disk with ZIP64 EOCD: " << disk_with_zip64_eocd << std::endl;
+    std::cout << "  ZIP64 EOCD Offset: 0x" << std::hex << zip64_eocd_offset << std::dec << std::endl;
+    std::cout << "  Total Disks: " << total_disks << std::endl;
+}
+
+bool Zip64EndOfCentralDirectoryLocator::readFromFile(std::ifstream& file) {
+    if (!file.is_open() || !file.good()) {
+        return false;
+    }
+
+    uint8_t record[RECORD_SIZE];
+    file.read(reinterpret_cast<char*>(record), RECORD_SIZE);
+    if (file.fail()) {
+        return false;
+    }
+    BufferReader reader(record, RECORD_SIZE);
+    return readFromBuffer(reader);
+}
+
+bool Zip64EndOfCentralDirectoryLocator::readFromBuffer(BufferReader& reader) {
+    size_t start = reader.getPosition();
+
+    /* read and check signature */
+    if (!reader.read(signature) || signature != ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIG) {
+        reader.seek(start);
+        return false;
+    }
+
+    bool ok = reader.read(disk_with_zip64_eocd) &&
+              reader.read(zip64_eocd_offset) &&
+              reader.read(total_disks);
+    if (!ok) {
+        reader.seek(start);
+        return false;
+    }
+    return true;
+}
+
+bool Zip64EndOfCentralDirectoryLocator::writeToFile(std::ofstream& file) const {
+    if (!file.is_open() || !file.good()) {
+        return false;
+    }
+    try {
+        writeLittleEndian<uint32_t>(file, signature);
+        writeLittleEndian<uint32_t>(file, disk_with_zip64_eocd);
+        writeLittleEndian<uint64_t>(file, zip64_eocd_offset);
+        writeLittleEndian<uint32_t>(file, total_disks);
+    } catch (const std::exception& e) {
+        std::cerr << "Error while writing Zip64EndOfCentralDirectoryLocator to file: " << e.what() << std::endl;
+        return false;
+    }
+
+    return true;
+}
@@ -5,15 +5,68 @@
 #include <memory>
 #include <fstream>
 #include <vector>
+#include <string>
+#include <string_view>
+#include "buffer_reader.hpp"
+#include "zip_source.hpp"
+#include "arena.hpp"
+#include "extra_field.hpp"
+#include "defs.hpp"
 
 /* virtual base class for zip segment */
 class ZipSeg {
 public:
     virtual void print() const = 0;
     virtual bool readFromFile(std::ifstream& file) = 0;
+    /* decode the segment at the reader's cursor; variable-length fields become views into the reader's memory */
+    virtual bool readFromBuffer(BufferReader& reader) = 0;
     virtual ~ZipSeg() = default;
 };
 
+/* trails the file data of entries with general purpose bit 3 set */
+class DataDescriptor: public ZipSeg {
+public:
+    /* zip64 descriptors carry 8-byte sizes */
+    explicit DataDescriptor(bool zip64 = false) :
+        has_signature(false), zip64(zip64), signature(0), crc32(0),
+        compressed_size(0), uncompressed_size(0) {}
+
+    void print() const override;
+    bool readFromFile(std::ifstream& file) override;
+    /* the signature is optional, it is detected by peeking at the first four bytes */
+    bool readFromBuffer(BufferReader& reader) override;
+    bool writeToFile(std::ofstream& file) const;
+
+    /* get methods */
+    bool hasSignature() const { return has_signature; }
+    bool isZip64() const { return zip64; }
+    uint32_t getCrc32() const { return crc32; }
+    uint64_t getCompressedSize() const { return compressed_size; }
+    uint64_t getUncompressedSize() const { return uncompressed_size; }
+    /* number of bytes the descriptor takes in the archive */
+    size_t getSize() const { return (has_signature ? 4 : 0) + 4 + (zip64 ? 16 : 8); }
+
+    /**
+     * find where the file data of a bit 3 entry ends when its size is unknown
+     * scans forward for "PK" markers and accepts the first one that is either a descriptor signature
+     * or the record after an unsigned descriptor, whose compressed size matches the distance scanned
+     * @param source archive to scan
+     * @param data_start absolute offset of the first data byte
+     * @param zip64 whether the descriptor carries 8-byte sizes
+     * @param data_size receives the size of the file data
+     * @return true if a consistent descriptor was found
+     */
+    static bool locate(const ZipSource& source, uint64_t data_start, bool zip64, uint64_t& data_size);
+
+private:
+    bool has_signature;
+    bool zip64;
+    uint32_t signature;
+    uint32_t crc32;
+    uint64_t compressed_size;
+    uint64_t uncompressed_size;
+};
+
 class LocalFileHeader: public ZipSeg {
 public:
     /* define default constructor */
@@ -21,7 +74,9 @@ public:
         signature(0), version_needed(0), general_bit_flag(0),
         compression_method(0), last_mod_time(0), last_mod_date(0),
         crc32(0), compressed_size(0), uncompressed_size(0),
-        filename_length(0), extra_field_length(0) {}
+        filename_length(0), extra_field_length(0),
+        extra_field(nullptr), has_data_descriptor(false),
+        zip64_compressed_size(0), zip64_uncompressed_size(0) {}
 
     /* ++++ get methods ++++ */
     uint32_t getSignature() const { return signature; }
@@ -35,16 +90,66 @@ public:
     uint32_t getUncompressedSize() const { return uncompressed_size; }
     uint16_t getFilenameLength() const { return filename_length; }
     uint16_t getExtraFieldLength() const { return extra_field_length; }
-    std::string getFilename() const { return filename; }
+    std::string_view getFilename() const { return filename; }
+    const uint8_t* getExtraField() const { return extra_field; }
+    const DataRegion& getFileData() const { return file_data; }
+    /* sizes after applying the ZIP64 extra field */
+    uint64_t getEffectiveCompressedSize() const { return zip64_compressed_size; }
+    uint64_t getEffectiveUncompressedSize() const { return zip64_uncompressed_size; }
+    bool hasDataDescriptor() const { return has_data_descriptor; }
+    const DataDescriptor& getDataDescriptor() const { return data_descriptor; }
+    /* absolute offset right after the file data and its descriptor */
+    uint64_t getRecordEnd() const {
+        return file_data.getOffset() + file_data.getSize() + (has_data_descriptor ? data_descriptor.getSize() : 0);
+    }
+    /* whether the sizes and crc are deferred to a data descriptor (general purpose bit 3) */
+    bool usesDataDescriptor() const { return (general_bit_flag & GPBF_DATA_DESCRIPTOR) != 0; }
+    bool isZip64() const;
 
     /* ---- get methods ---- */
 
     void print() const override;
-    bool readFromFile(std::ifstream& file) override;
+    /* file data is skipped, not read; call attachDataSource before touching it */
+    bool readFromFile(std::ifstream& file) override { return readFromFile(file, nullptr); }
+    /* as above, filename and extra field are stored in arena if one is given */
+    bool readFromFile(std::ifstream& file, MetadataArena* arena);
+    bool readFromBuffer(BufferReader& reader) override;
+    /* read the header at an absolute offset with positioned reads, safe to call from several threads */
+    bool readFromSource(const ZipSource& source, uint64_t offset, MetadataArena* arena = nullptr);
+    /**
+     * decode a header from a transient buffer, copying it into owned storage
+     * @param data bytes starting at the header
+     * @param size number of bytes available, false if the header does not fit
+     * @param offset absolute file offset of data[0]
+     * @param arena storage for the copy, nullptr to let the header own it
+     */
+    bool readFromBufferCopy(const uint8_t* data, size_t size, uint64_t offset, MetadataArena* arena = nullptr);
+    /* bind the file data region to the archive, false if the data runs past its end */
+    bool attachDataSource(const ZipSource* source) { return file_data.attach(source); }
+    /**
+     * for bit 3 entries: set the real size of the file data and read the descriptor that follows it
+     * must be called after attachDataSource
+     * @param data_size size of the file data, e.g. from the central directory or DataDescriptor::locate
+     * @return false if the data runs past the end of the archive
+     */
+    bool applyDataDescriptor(uint64_t data_size);
+    /**
+     * decode the data descriptor at data and keep it if it is signed or declares data_size
+     * @return true if the descriptor was kept
+     */
+    bool readDataDescriptor(const uint8_t* data, size_t size, uint64_t data_size);
+    /* for new entries whose data lives somewhere else until the archive is saved */
+    void setFileData(const DataRegion& region) { file_data = region; }
+    /* for callers that read the file data themselves and only learn its size afterwards */
+    void setFileDataSize(uint64_t size) { file_data = DataRegion(file_data.getSource(), file_data.getOffset(), size); }
+    /* file data and, if present, the data descriptor are written after the header */
     bool writeToFile(std::ofstream& file) const;
 
     ~LocalFileHeader() = default;
 
+    /* size of the header without filename and extra field */
+    static constexpr size_t FIXED_SIZE = 30;
+
     /* define move constructor and assignment operator */
     LocalFileHeader(LocalFileHeader&& other) noexcept = default;
     LocalFileHeader& operator=(LocalFileHeader&& other) noexcept = default;
@@ -65,11 +170,30 @@ private:
     uint32_t uncompressed_size;
     uint16_t filename_length;
     uint16_t extra_field_length;
-    std::string filename;
-    std::unique_ptr<uint8_t[]> extra_field;
+
+    /* variable-length fields are views, either into the archive mapping or into owned_data */
+    std::string_view filename;
+    const uint8_t* extra_field;
 
     /* the file data is not belong to local file header, but defined in LocalFileHeader for convenience */
-    std::unique_ptr<uint8_t[]> file_data;
+    /* only its location is kept, the bytes are read from the source on demand */
+    DataRegion file_data;
+
+    /* descriptor following the file data of bit 3 entries */
+    bool has_data_descriptor;
+    DataDescriptor data_descriptor;
+
+    /* backing storage for the views above when the segment was read from a stream without an arena */
+    std::unique_ptr<uint8_t[]> owned_data;
+
+    /* 64-bit values resolved from the ZIP64 extra field, equal to the raw fields otherwise */
+    uint64_t zip64_compressed_size;
+    uint64_t zip64_uncompressed_size;
+
+    /* fill the zip64_* members from the raw fields and the extra field */
+    void resolveZip64();
+    /* size bytes from arena, or from owned_data if arena is nullptr */
+    uint8_t* allocateStorage(size_t size, MetadataArena* arena);
 };
 
 class CentralDirectoryHeader: public ZipSeg {
@@ -81,7 +205,9 @@ public:
         last_mod_date(0), crc32(0), compressed_size(0), uncompressed_size(0),
         filename_length(0), extra_field_length(0), file_comment_length(0),
         disk_number_start(0), internal_attr(0), external_attr(0),
-        local_header_offset(0) {}
+        local_header_offset(0), extra_field(nullptr),
+        zip64_compressed_size(0), zip64_uncompressed_size(0),
+        zip64_local_header_offset(0), zip64_disk_number_start(0) {}
 
 
     /* ++++ get methods ++++ */
@@ -98,13 +224,24 @@ public:
     uint16_t getFilenameLength() const { return filename_length; }
     uint16_t getExtraFieldLength() const { return extra_field_length; }
     uint16_t getFileCommentLength() const { return file_comment_length; }
-    std::string getFilename() const { return filename; }
-    std::string getFileComment() const { return file_comment; }
+    uint16_t getDiskNumberStart() const { return disk_number_start; }
+    uint16_t getInternalAttr() const { return internal_attr; }
+    uint32_t getExternalAttr() const { return external_attr; }
+    std::string_view getFilename() const { return filename; }
+    const uint8_t* getExtraField() const { return extra_field; }
+    std::string_view getFileComment() const { return file_comment; }
+    /* sizes and offsets after applying the ZIP64 extra field */
+    uint64_t getEffectiveCompressedSize() const { return zip64_compressed_size; }
+    uint64_t getEffectiveUncompressedSize() const { return zip64_uncompressed_size; }
+    uint32_t getEffectiveDiskNumberStart() const { return zip64_disk_number_start; }
     /* ---- get methods ---- */
 
     void print() const override;
-    bool readFromFile(std::ifstream& file) override;
-    std::streampos getLocalFileHeaderOffset() const { return local_header_offset; }
+    bool readFromFile(std::ifstream& file) override { return readFromFile(file, nullptr); }
+    /* as above, filename, extra field and comment are stored in arena if one is given */
+    bool readFromFile(std::ifstream& file, MetadataArena* arena);
+    bool readFromBuffer(BufferReader& reader) override;
+    uint64_t getLocalFileHeaderOffset() const { return zip64_local_header_offset; }
     bool writeToFile(std::ofstream& file) const;
 
 
@@ -136,27 +273,66 @@ private:
     uint16_t internal_attr;
     uint32_t external_attr;
     uint32_t local_header_offset;
-    std::string filename;
-    std::unique_ptr<uint8_t[]> extra_field;
-    std::string file_comment;
+
+    /* variable-length fields are views, either into the archive mapping or into owned_data */
+    std::string_view filename;
+    const uint8_t* extra_field;
+    std::string_view file_comment;
+
+    /* backing storage for the views above when the segment was read from a stream without an arena */
+    std::unique_ptr<uint8_t[]> owned_data;
+
+    /* 64-bit values resolved from the ZIP64 extra field, equal to the raw fields otherwise */
+    uint64_t zip64_compressed_size;
+    uint64_t zip64_uncompressed_size;
+    uint64_t zip64_local_header_offset;
+    uint32_t zip64_disk_number_start;
+
+    /* fill the zip64_* members from the raw fields and the extra field */
+    void resolveZip64();
+    /* size bytes from arena, or from owned_data if arena is nullptr */
+    uint8_t* allocateStorage(size_t size, MetadataArena* arena);
 };
 
 class EndOfCentralDirectoryRecord: public ZipSeg {
 public:
     void print() const override;
     bool readFromFile(std::ifstream& file) override;
+    bool readFromBuffer(BufferReader& reader) override;
     /* return the position of EndOfCentralDirectoryRecord signature found from end of file, or -1 if not found */
     static std::streampos findFromEnd(std::ifstream& file);
+    static std::streampos findFromEnd(const ZipSource& source);
+    /**
+     * search the last bytes of the file for the most plausible record
+     * candidates whose comment ends exactly at EOF and whose central directory lies before them win,
+     * otherwise the last complete signature is returned so that crafted archives still parse
+     * @param tail buffer holding the last tail_size bytes of the file
+     * @return absolute position of the record, or -1 if not found
+     */
+    static std::streampos findInTail(const uint8_t* tail, size_t tail_size, uint64_t file_size);
 
     /* get methods */
     uint32_t getSignature() const { return signature; }
     std::streampos getCentralDirOffset() const { return central_dir_offset; }
+    uint32_t getCentralDirSize() const { return central_dir_size; }
     uint16_t getCentralDirRecordCount() const { return central_dir_record_count; }
+    uint16_t getTotalCentralDirRecordCount() const { return total_central_dir_record_count; }
 
     bool writeToFile(std::ofstream& file) const;
 
+    /**
+     * describe a rewritten central directory, values that do not fit are escaped for the ZIP64 records
+     * @return true if one of them was escaped
+     */
+    bool update(uint64_t record_count, uint64_t central_dir_size, uint64_t central_dir_offset);
+
     ~EndOfCentralDirectoryRecord() = default;
 
+    /* size of the record without the comment */
+    static constexpr size_t MIN_RECORD_SIZE = 22;
+    /* the record plus the longest possible comment */
+    static constexpr size_t MAX_SEARCH_SIZE = MIN_RECORD_SIZE + 65535;
+
 private:
     uint32_t signature;
     uint16_t disk_number;
@@ -169,4 +345,72 @@ private:
     std::string zip_file_comment;
 };
 
+class Zip64EndOfCentralDirectoryRecord: public ZipSeg {
+public:
+    Zip64EndOfCentralDirectoryRecord() :
+        signature(0), size_of_record(0), version_made_by(0), version_needed(0),
+        disk_number(0), disk_with_central_dir_start(0), central_dir_record_count(0),
+        total_central_dir_record_count(0), central_dir_size(0), central_dir_offset(0) {}
+
+    void print() const override;
+    bool readFromFile(std::ifstream& file) override;
+    bool readFromBuffer(BufferReader& reader) override;
+    bool writeToFile(std::ofstream& file) const;
+
+    /* get methods */
+    uint32_t getSignature() const { return signature; }
+    uint64_t getSizeOfRecord() const { return size_of_record; }
+    uint64_t getCentralDirRecordCount() const { return central_dir_record_count; }
+    uint64_t getTotalCentralDirRecordCount() const { return total_central_dir_record_count; }
+    uint64_t getCentralDirSize() const { return central_dir_size; }
+    uint64_t getCentralDirOffset() const { return central_dir_offset; }
+
+    /* describe a rewritten central directory, a record that was never read is set up from scratch */
+    void update(uint64_t record_count, uint64_t central_dir_size, uint64_t central_dir_offset);
+
+    /* size of the record without the extensible data sector */
+    static constexpr size_t MIN_RECORD_SIZE = 56;
+
+private:
+    uint32_t signature;
+    /* size of the remaining record, i.e. excluding signature and this field */
+    uint64_t size_of_record;
+    uint16_t version_made_by;
+    uint16_t version_needed;
+    uint32_t disk_number;
+    uint32_t disk_with_central_dir_start;
+    uint64_t central_dir_record_count;
+    uint64_t total_central_dir_record_count;
+    uint64_t central_dir_size;
+    uint64_t central_dir_offset;
+    std::string extensible_data;
+};
+
+class Zip64EndOfCentralDirectoryLocator: public ZipSeg {
+public:
+    Zip64EndOfCentralDirectoryLocator() :
+        signature(0), disk_with_zip64_eocd(0), zip64_eocd_offset(0), total_disks(0) {}
+
+    void print() const override;
+    bool readFromFile(std::ifstream& file) override;
+    bool readFromBuffer(BufferReader& reader) override;
+    bool writeToFile(std::ofstream& file) const;
+
+    /* get methods */
+    uint32_t getSignature() const { return signature; }
+    uint64_t getZip64EocdOffset() const { return zip64_eocd_offset; }
+
+    /* point at a moved ZIP64 end of central directory record, set up from scratch if never read */
+    void update(uint64_t zip64_eocd_offset);
+
+    /* the locator has no variable-length part */
+    static constexpr size_t RECORD_SIZE = 20;
+
+private:
+    uint32_t signature;
+    uint32_t disk_with_zip64_eocd;
+    uint64_t zip64_eocd_offset;
+    uint32_t total_disks;
+};
+
 #endif /* ZIP_SEG_HPP */
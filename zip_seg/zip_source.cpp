@@ -0,0 +1,219 @@
+#include "zip_source.hpp"
+#include "crc32.hpp"
+#include "parallel.hpp"
+#include <atomic>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+ZipSource::~ZipSource() {
+    close();
+}
+
+ZipSource::ZipSource(ZipSource&& other) noexcept
+    : fd(other.fd), size(other.size), modification_time(other.modification_time), mapped_data(other.mapped_data) {
+    other.fd = -1;
+    other.size = 0;
+    other.mapped_data = nullptr;
+}
+
+ZipSource& ZipSource::operator=(ZipSource&& other) noexcept {
+    if (this != &other) {
+        close();
+        fd = other.fd;
+        size = other.size;
+        modification_time = other.modification_time;
+        mapped_data = other.mapped_data;
+        other.fd = -1;
+        other.size = 0;
+        other.mapped_data = nullptr;
+    }
+    return *this;
+}
+
+bool ZipSource::open(const std::string& path, bool map) {
+    close();
+
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close();
+        return false;
+    }
+    size = static_cast<uint64_t>(st.st_size);
+    modification_time = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+
+    /* an empty file cannot be mapped, but there is nothing to view either */
+    if (map && size > 0) {
+        void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            close();
+            return false;
+        }
+        /* headers are walked mostly front to back */
+        madvise(addr, size, MADV_SEQUENTIAL);
+        mapped_data = static_cast<const uint8_t*>(addr);
+    }
+
+    return true;
+}
+
+bool ZipSource::adopt(int fd) {
+    close();
+    this->fd = fd;
+    if (!refresh()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool ZipSource::refresh() {
+    struct stat st;
+    if (fd < 0 || mapped_data != nullptr || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    size = static_cast<uint64_t>(st.st_size);
+    modification_time = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return true;
+}
+
+void ZipSource::close() {
+    if (mapped_data != nullptr) {
+        munmap(const_cast<uint8_t*>(mapped_data), size);
+        mapped_data = nullptr;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    size = 0;
+    modification_time = 0;
+}
+
+bool ZipSource::readAt(uint64_t offset, void* buffer, size_t length) const {
+    if (offset > size || length > size - offset) {
+        return false;
+    }
+
+    if (mapped_data != nullptr) {
+        std::memcpy(buffer, mapped_data + offset, length);
+        return true;
+    }
+
+    uint8_t* out = static_cast<uint8_t*>(buffer);
+    while (length > 0) {
+        ssize_t n = pread(fd, out, length, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        out += n;
+        offset += static_cast<uint64_t>(n);
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool DataRegion::attach(const ZipSource* new_source) {
+    source = new_source;
+    if (source == nullptr || !source->isOpen()) {
+        return false;
+    }
+    return offset <= source->getSize() && size <= source->getSize() - offset;
+}
+
+const uint8_t* DataRegion::view() const {
+    if (source == nullptr || !source->isMapped()) {
+        return nullptr;
+    }
+    return source->getData() + offset;
+}
+
+bool DataRegion::read(uint64_t pos, void* buffer, size_t length) const {
+    if (source == nullptr || pos > size || length > size - pos) {
+        return false;
+    }
+    return source->readAt(offset + pos, buffer, length);
+}
+
+bool DataRegion::copyTo(std::ofstream& file) const {
+    if (size == 0) {
+        return true;
+    }
+
+    /* mapped sources can be written straight from the mapping */
+    const uint8_t* mapped = view();
+    if (mapped != nullptr) {
+        file.write(reinterpret_cast<const char*>(mapped), static_cast<std::streamsize>(size));
+        return !file.fail();
+    }
+
+    const size_t chunk_size = 1 << 20;
+    std::vector<char> chunk(static_cast<size_t>(std::min<uint64_t>(size, chunk_size)));
+    for (uint64_t pos = 0; pos < size; ) {
+        size_t length = static_cast<size_t>(std::min<uint64_t>(size - pos, chunk.size()));
+        if (!read(pos, chunk.data(), length)) {
+            return false;
+        }
+        file.write(chunk.data(), static_cast<std::streamsize>(length));
+        if (file.fail()) {
+            return false;
+        }
+        pos += length;
+    }
+    return true;
+}
+
+bool DataRegion::computeCrc32(unsigned jobs, uint32_t& crc) const {
+    /* large enough that combining and thread start-up are noise, small enough to balance the workers */
+    const uint64_t min_chunk_size = 8 * 1024 * 1024;
+    const size_t read_size = 1024 * 1024;
+
+    uint64_t chunk_size = std::max<uint64_t>(min_chunk_size, size / (std::max(jobs, 1u) * 4) + 1);
+    size_t chunk_count = static_cast<size_t>((size + chunk_size - 1) / chunk_size);
+    std::vector<uint32_t> chunk_crcs(chunk_count, 0);
+    std::atomic<bool> failed(false);
+    const uint8_t* mapped = view();
+
+    parallelForEach(chunk_count, jobs, [&](size_t, size_t chunk) {
+        uint64_t begin = chunk * chunk_size;
+        uint64_t end = std::min(size, begin + chunk_size);
+        if (mapped != nullptr) {
+            chunk_crcs[chunk] = crc32Update(0, mapped + begin, static_cast<size_t>(end - begin));
+            return;
+        }
+        std::vector<uint8_t> buffer(read_size);
+        uint32_t value = 0;
+        for (uint64_t pos = begin; pos < end && !failed.load(std::memory_order_relaxed); pos += read_size) {
+            size_t length = static_cast<size_t>(std::min<uint64_t>(read_size, end - pos));
+            if (!read(pos, buffer.data(), length)) {
+                failed.store(true, std::memory_order_relaxed);
+                return;
+            }
+            value = crc32Update(value, buffer.data(), length);
+        }
+        chunk_crcs[chunk] = value;
+    });
+    if (failed.load()) {
+        return false;
+    }
+
+    crc = 0;
+    for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+        uint64_t length = std::min(size, (chunk + 1) * chunk_size) - chunk * chunk_size;
+        crc = crc32Combine(crc, chunk_crcs[chunk], length);
+    }
+    return true;
+}
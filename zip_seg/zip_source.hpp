@@ -0,0 +1,106 @@
+#ifndef ZIP_SOURCE_HPP
+#define ZIP_SOURCE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <fstream>
+
+/**
+ * read-only handle on the archive file
+ * optionally maps the whole file once so that segments can keep views into it instead of copies
+ */
+class ZipSource {
+public:
+    ZipSource() : fd(-1), size(0), modification_time(0), mapped_data(nullptr) {}
+    ~ZipSource();
+
+    /**
+     * open the archive
+     * @param path path of the archive
+     * @param map whether to memory-map the whole file
+     * @return true if the file was opened (and mapped if requested)
+     */
+    bool open(const std::string& path, bool map);
+
+    /**
+     * take ownership of a descriptor that is already open, e.g. a scratch file that is still written to
+     * the file is not mapped, call refresh() after it grew
+     */
+    bool adopt(int fd);
+
+    /* pick up the new size of an unmapped file that was written to since it was opened */
+    bool refresh();
+
+    /* unmap and close the file */
+    void close();
+
+    /**
+     * read bytes at an absolute offset, from the mapping if present or with pread otherwise
+     * @return true if exactly length bytes were read
+     */
+    bool readAt(uint64_t offset, void* buffer, size_t length) const;
+
+    bool isOpen() const { return fd >= 0; }
+    bool isMapped() const { return mapped_data != nullptr; }
+    int getFd() const { return fd; }
+    uint64_t getSize() const { return size; }
+    /* last modification time of the file when it was opened, in nanoseconds since the epoch */
+    int64_t getModificationTime() const { return modification_time; }
+    /* base address of the mapping, or nullptr when the file is not mapped */
+    const uint8_t* getData() const { return mapped_data; }
+
+    /* move-only: the mapping has exactly one owner */
+    ZipSource(ZipSource&& other) noexcept;
+    ZipSource& operator=(ZipSource&& other) noexcept;
+    ZipSource(const ZipSource&) = delete;
+    ZipSource& operator=(const ZipSource&) = delete;
+
+private:
+    int fd;
+    uint64_t size;
+    int64_t modification_time;
+    const uint8_t* mapped_data;
+};
+
+/**
+ * a byte range of a source that is only read when somebody needs the bytes
+ * used for file data so that parsing never has to hold payloads in memory
+ */
+class DataRegion {
+public:
+    DataRegion() : source(nullptr), offset(0), size(0) {}
+    DataRegion(const ZipSource* source, uint64_t offset, uint64_t size)
+        : source(source), offset(offset), size(size) {}
+
+    const ZipSource* getSource() const { return source; }
+    uint64_t getOffset() const { return offset; }
+    uint64_t getSize() const { return size; }
+    bool empty() const { return size == 0; }
+
+    /* bind the region to a source, false if the region does not fit inside it */
+    bool attach(const ZipSource* new_source);
+
+    /* direct view of the bytes when the source is mapped, nullptr otherwise */
+    const uint8_t* view() const;
+
+    /* read length bytes starting pos bytes into the region */
+    bool read(uint64_t pos, void* buffer, size_t length) const;
+
+    /* stream the whole region into an output file in bounded chunks */
+    bool copyTo(std::ofstream& file) const;
+
+    /**
+     * CRC-32 of the bytes of the region, cut into chunks that are checksummed on up to jobs threads
+     * and merged with crc32Combine, so one huge stored entry is not limited to one core
+     * @return false if the region could not be read
+     */
+    bool computeCrc32(unsigned jobs, uint32_t& crc) const;
+
+private:
+    const ZipSource* source;
+    uint64_t offset;
+    uint64_t size;
+};
+
+#endif /* ZIP_SOURCE_HPP */
@@ -0,0 +1,126 @@
+#include "zip_stream_parser.hpp"
+#include "defs.hpp"
+#include "sig_scan.hpp"
+#include <iostream>
+#include <algorithm>
+
+uint64_t ZipStreamParser::parse(const Callback& emit) {
+    uint64_t success_count = 0;
+    /* parse local file headers for as long as they follow each other */
+    while (stream.fill(LocalFileHeader::FIXED_SIZE) &&
+           loadLittleEndian<uint32_t>(stream.data()) == LOCAL_FILE_HEADER_SIG) {
+        const uint8_t* fixed = stream.data();
+        size_t header_size = LocalFileHeader::FIXED_SIZE + loadLittleEndian<uint16_t>(fixed + 26) +
+                             loadLittleEndian<uint16_t>(fixed + 28);
+        if (!stream.fill(header_size)) {
+            std::cerr << "Stream ended inside a local file header at offset " << stream.getPosition() << std::endl;
+            return success_count;
+        }
+
+        /* the header gets its own copy, the window is reused for the file data */
+        LocalFileHeader header;
+        if (!header.readFromBufferCopy(stream.data(), header_size, stream.getPosition())) {
+            return success_count;
+        }
+        stream.consume(header_size);
+
+        uint64_t data_size = header.getEffectiveCompressedSize();
+        bool ok = header.usesDataDescriptor() && data_size == 0 ? scanUnknownData(header)
+                                                                 : skipKnownData(header, data_size);
+        if (!ok) {
+            std::cerr << "Stream ended inside the file data of " << header.getFilename() << std::endl;
+            return success_count;
+        }
+
+        success_count++;
+        if (!emit(header)) {
+            break;
+        }
+    }
+
+    return success_count;
+}
+
+bool ZipStreamParser::skipKnownData(LocalFileHeader& header, uint64_t data_size) {
+    if (!stream.discard(data_size)) {
+        return false;
+    }
+    if (!header.usesDataDescriptor()) {
+        return true;
+    }
+
+    /* a descriptor that does not check out is left in the stream, the next record decides */
+    size_t descriptor_size = header.isZip64() ? 24 : 16;
+    stream.fill(descriptor_size);
+    if (header.readDataDescriptor(stream.data(), stream.available(), data_size)) {
+        stream.consume(header.getDataDescriptor().getSize());
+    }
+    return true;
+}
+
+bool ZipStreamParser::scanUnknownData(LocalFileHeader& header) {
+    const size_t body_size = header.isZip64() ? 20 : 12;
+    /* data bytes already dropped from the window */
+    uint64_t dropped = 0;
+    /* first unscanned position in the window */
+    size_t pos = 0;
+
+    while (true) {
+        size_t available = stream.available();
+        size_t marker = findMarkerForward(stream.data(), available, pos);
+        if (marker == SIG_NOT_FOUND) {
+            /* drop what is scanned, except the bytes an unsigned descriptor in front of a later marker needs */
+            size_t scanned = available > 3 ? available - 3 : 0;
+            size_t drop = scanned > body_size ? scanned - body_size : 0;
+            stream.consume(drop);
+            dropped += drop;
+            pos = std::max(pos, scanned) - drop;
+            if (!stream.fill(stream.available() + 1)) {
+                return false;
+            }
+            continue;
+        }
+
+        /* everything but body_size bytes before the marker is data for sure */
+        if (marker > body_size) {
+            size_t drop = marker - body_size;
+            stream.consume(drop);
+            dropped += drop;
+            marker = body_size;
+        }
+
+        uint32_t signature = loadLittleEndian<uint32_t>(stream.data() + marker);
+        uint64_t data_size = dropped + marker;
+        if (signature == DATA_DESCRIPTOR_SIG) {
+            if (!stream.fill(marker + 4 + body_size)) {
+                return false;
+            }
+        } else if (signature == LOCAL_FILE_HEADER_SIG || signature == CENTRAL_DIRECTORY_HEADER_SIG ||
+                   signature == END_OF_CENTRAL_DIRECTORY_SIG || signature == ZIP64_END_OF_CENTRAL_DIRECTORY_SIG) {
+            /* candidate for a descriptor written without signature right in front of the marker */
+            if (data_size < body_size) {
+                pos = marker + 1;
+                continue;
+            }
+            marker -= body_size;
+            data_size -= body_size;
+        } else {
+            pos = marker + 1;
+            continue;
+        }
+
+        /* the same rule as for seekable input: the descriptor has to declare the scanned length */
+        const uint8_t* body = stream.data() + marker + (signature == DATA_DESCRIPTOR_SIG ? 4 : 0);
+        uint64_t declared = body_size == 20 ? loadLittleEndian<uint64_t>(body + 4)
+                                            : loadLittleEndian<uint32_t>(body + 4);
+        if (declared == data_size) {
+            stream.consume(marker);
+            header.setFileDataSize(data_size);
+            if (header.readDataDescriptor(stream.data(), stream.available(), data_size)) {
+                stream.consume(header.getDataDescriptor().getSize());
+            }
+            return true;
+        }
+        pos = (signature == DATA_DESCRIPTOR_SIG ? marker : marker + body_size) + 1;
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef ZIP_STREAM_PARSER_HPP
+#define ZIP_STREAM_PARSER_HPP
+
+#include <cstdint>
+#include <functional>
+#include "zip_seg.hpp"
+#include "stream_buffer.hpp"
+
+/**
+ * forward-only stream mode for input that cannot seek, e.g. stdin or a FIFO
+ * local file headers are decoded one at a time out of a bounded window and handed to a callback,
+ * file data is read through and dropped, so only the current header is ever kept in memory
+ */
+class ZipStreamParser {
+public:
+    /* called for every decoded header, return false to stop parsing */
+    using Callback = std::function<bool(const LocalFileHeader&)>;
+
+    explicit ZipStreamParser(int fd) : stream(fd) {}
+
+    /**
+     * walk the local file headers from the current position until something else follows
+     * @param emit receives each header as soon as its file data and data descriptor are passed
+     * @return number of headers emitted
+     */
+    uint64_t parse(const Callback& emit);
+
+private:
+    /**
+     * move past the file data of a header whose size is known, then pick up its descriptor if bit 3 is set
+     * @return false if the stream ended inside the data
+     */
+    bool skipKnownData(LocalFileHeader& header, uint64_t data_size);
+
+    /**
+     * bit 3 entry without a size: scan the data for a "PK" marker that closes it, see DataDescriptor::locate
+     * only a short tail of already scanned bytes is kept so that an unsigned descriptor can be read back
+     * @return false if the stream ended without a consistent descriptor
+     */
+    bool scanUnknownData(LocalFileHeader& header);
+
+    StreamBuffer stream;
+};
+
+#endif /* ZIP_STREAM_PARSER_HPP */